@@ -1,5 +1,10 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace hypha {
 
@@ -7,6 +12,9 @@ namespace hypha {
         uint64_t decayPeriod;
         uint64_t evaluationTime;
         double   decayPerPeriod;
+        // Periods end on multiples of decayPeriod since the unix epoch instead
+        // of decayPeriod after the last decay of each balance
+        bool     alignToEpoch = false;
     };
 
     struct DecayResult {
@@ -15,6 +23,394 @@ namespace hypha {
         uint64_t newPeriod;
     };
 
+    // Number of periods of a balance that never falls below a threshold
+    constexpr uint64_t DECAY_NEVER = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * Decay policies. `factor` is the share of a balance kept after `periods`
+     * whole periods, `scale` applies it and `apply` does both. Policies with
+     * `decays = false` never touch a balance.
+     *
+     * `periods_below` solves `apply(balance, periods) < threshold` for the
+     * fewest periods in closed form, for a balance not already below. Floating
+     * point may leave it one period off, see decay_below.
+     *
+     * Policies with `anchored = true` decay from the balance of the last change
+     * other than decay (see DecayAnchor) instead of the last settlement.
+     */
+    struct NoDecay {
+        static constexpr bool decays = false;
+        static constexpr bool anchored = false;
+
+        static double factor(const uint64_t periods, const double decayPerPeriod) {
+            return 1.0;
+        }
+
+        static uint64_t scale(const uint64_t balance, const double factor) {
+            return balance;
+        }
+
+        static uint64_t apply(const uint64_t balance, const uint64_t periods, const double decayPerPeriod) {
+            return balance;
+        }
+
+        static uint64_t periods_below(const uint64_t balance, const uint64_t threshold, const double decayPerPeriod) {
+            return DECAY_NEVER;
+        }
+    };
+
+    struct ExponentialDecay {
+        static constexpr bool decays = true;
+        static constexpr bool anchored = false;
+
+        static double factor(const uint64_t periods, const double decayPerPeriod) {
+            return pow(1.0f - decayPerPeriod, periods);
+        }
+
+        static uint64_t scale(const uint64_t balance, const double factor) {
+            return (uint64_t) round(balance * factor);
+        }
+
+        static uint64_t apply(const uint64_t balance, const uint64_t periods, const double decayPerPeriod) {
+            return scale(balance, factor(periods, decayPerPeriod));
+        }
+
+        // round(b * (1 - d)^k) < t  <=>  k > log((t - 0.5) / b) / log(1 - d)
+        static uint64_t periods_below(const uint64_t balance, const uint64_t threshold, const double decayPerPeriod) {
+            if (threshold == 0 || decayPerPeriod <= 0) {
+                return DECAY_NEVER;
+            }
+            const double kept = 1.0f - decayPerPeriod;
+            if (kept <= 0) {
+                return 1;
+            }
+            const double periods = std::floor(std::log((threshold - 0.5) / balance) / std::log(kept)) + 1;
+            return periods >= 0x1p63 ? DECAY_NEVER : (uint64_t) periods;
+        }
+    };
+
+    // Loses `decayPerPeriod` of the anchor balance every period. Scaling the
+    // last settled balance again would compound into exponential decay
+    struct LinearDecay {
+        static constexpr bool decays = true;
+        static constexpr bool anchored = true;
+
+        static double factor(const uint64_t periods, const double decayPerPeriod) {
+            const double kept = 1.0 - decayPerPeriod * periods;
+            return kept <= 0 ? 0 : kept;
+        }
+
+        static uint64_t scale(const uint64_t balance, const double factor) {
+            return (uint64_t) round(balance * factor);
+        }
+
+        static uint64_t apply(const uint64_t balance, const uint64_t periods, const double decayPerPeriod) {
+            return scale(balance, factor(periods, decayPerPeriod));
+        }
+
+        // round(b * (1 - d * k)) < t  <=>  k > (1 - (t - 0.5) / b) / d
+        static uint64_t periods_below(const uint64_t balance, const uint64_t threshold, const double decayPerPeriod) {
+            if (threshold == 0 || decayPerPeriod <= 0) {
+                return DECAY_NEVER;
+            }
+            const double periods = std::floor((1.0 - (threshold - 0.5) / balance) / decayPerPeriod) + 1;
+            return periods >= 0x1p63 ? DECAY_NEVER : (uint64_t) periods;
+        }
+    };
+
+    // Policy of decaying tokens, picked per build with VOICE_DECAY_POLICY
+#if defined(VOICE_DECAY_NONE)
+    using BuildDecayPolicy = NoDecay;
+#elif defined(VOICE_DECAY_LINEAR)
+    using BuildDecayPolicy = LinearDecay;
+#else
+    using BuildDecayPolicy = ExponentialDecay;
+#endif
+
+    struct DecayPeriods {
+        uint64_t periods;
+        uint64_t newPeriod;
+    };
+
+    // Whole periods from `lastPeriod` to the evaluation time, which must not be before it
+    inline DecayPeriods decay_periods(const uint64_t lastPeriod, const DecayConfig& config) {
+        if (config.alignToEpoch) {
+            const uint64_t epoch = config.evaluationTime / config.decayPeriod;
+            return DecayPeriods{
+                    .periods   = epoch - lastPeriod / config.decayPeriod,
+                    .newPeriod = epoch * config.decayPeriod
+            };
+        }
+
+        const uint64_t periods = (config.evaluationTime - lastPeriod) / config.decayPeriod;
+        return DecayPeriods{
+                .periods   = periods,
+                .newPeriod = lastPeriod + periods * config.decayPeriod
+        };
+    }
+
+    /**
+     * Balance left by the last change of a balance other than decay, and the
+     * decay period it was made in. Until the next such change the balance is
+     * `apply(balance, periods since period)` however often it is settled.
+     */
+    struct DecayAnchor {
+        uint64_t balance;
+        uint64_t period;
+    };
+
+    // `factor(periods)` gives the share of the balance kept, see the policies
+    template<typename Policy, typename Factor>
+    const DecayResult decay_by_factor(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            Factor&& factor
+    ) {
+        if constexpr (!Policy::decays) {
+            return DecayResult{
+                    .needsUpdate = false,
+                    .newBalance  = currentBalance,
+                    .newPeriod   = lastPeriod
+            };
+        } else {
+            if (config.decayPerPeriod == 0 || config.decayPeriod == 0 || lastPeriod > config.evaluationTime) {
+                return DecayResult{
+                        .needsUpdate = false,
+                        .newBalance  = currentBalance,
+                        .newPeriod   = lastPeriod
+                };
+            }
+
+            const DecayPeriods elapsed = decay_periods(lastPeriod, config);
+            if (elapsed.periods >= 1) {
+                return DecayResult{
+                        .needsUpdate = true,
+                        .newBalance  = Policy::scale(currentBalance, factor(elapsed.periods)),
+                        .newPeriod   = elapsed.newPeriod
+                };
+            }
+
+            return DecayResult{
+                    .needsUpdate = false,
+                    .newBalance  = currentBalance,
+                    .newPeriod   = lastPeriod
+            };
+        }
+    }
+
+    // Anchored policies decay from `anchor`, the others from the last settlement.
+    // Decay never raises a balance, even from an anchor that doesn't match it
+    template<typename Policy, typename Factor>
+    const DecayResult decay_from_anchor(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const DecayAnchor& anchor,
+            Factor&& factor
+    ) {
+        if constexpr (!Policy::anchored) {
+            return decay_by_factor<Policy>(currentBalance, lastPeriod, config, factor);
+        } else {
+            const DecayResult result = decay_by_factor<Policy>(anchor.balance, anchor.period, config, factor);
+            if (!result.needsUpdate || result.newPeriod <= lastPeriod) {
+                return DecayResult{
+                        .needsUpdate = false,
+                        .newBalance  = currentBalance,
+                        .newPeriod   = lastPeriod
+                };
+            }
+            return DecayResult{
+                    .needsUpdate = true,
+                    .newBalance  = std::min(result.newBalance, currentBalance),
+                    .newPeriod   = result.newPeriod
+            };
+        }
+    }
+
+    template<typename Policy>
+    const DecayResult decay(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const DecayAnchor& anchor
+    ) {
+        return decay_from_anchor<Policy>(currentBalance, lastPeriod, config, anchor, [&](const uint64_t periods) {
+            return Policy::factor(periods, config.decayPerPeriod);
+        });
+    }
+
+    // Decay of a balance whose last change other than decay was its last settlement
+    template<typename Policy>
+    const DecayResult decay(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config
+    ) {
+        return decay<Policy>(currentBalance, lastPeriod, config, DecayAnchor{ currentBalance, lastPeriod });
+    }
+
+    /**
+     * Decays many balances to the same evaluation time, computing the factor
+     * of each number of periods once. With periods aligned to the epoch, every
+     * balance last decayed in the same epoch shares one factor.
+     */
+    template<typename Policy>
+    class DecayFactors {
+    public:
+        static constexpr std::size_t MAX_CACHED = 64;
+
+        explicit DecayFactors(const DecayConfig& config) : _config(config) {}
+
+        const DecayResult decay(const uint64_t currentBalance, const uint64_t lastPeriod, const DecayAnchor& anchor) {
+            return decay_from_anchor<Policy>(currentBalance, lastPeriod, _config, anchor, [&](const uint64_t periods) {
+                return factor(periods);
+            });
+        }
+
+        const DecayResult decay(const uint64_t currentBalance, const uint64_t lastPeriod) {
+            return decay(currentBalance, lastPeriod, DecayAnchor{ currentBalance, lastPeriod });
+        }
+
+        double factor(const uint64_t periods) {
+            for (const auto& cached : _factors) {
+                if (cached.first == periods) {
+                    return cached.second;
+                }
+            }
+            const double computed = Policy::factor(periods, _config.decayPerPeriod);
+            if (_factors.size() < MAX_CACHED) {
+                _factors.emplace_back(periods, computed);
+            }
+            return computed;
+        }
+
+    private:
+        DecayConfig                              _config;
+        std::vector<std::pair<uint64_t, double>> _factors;
+    };
+
+    // End of the `periods`th period after `lastPeriod`, DECAY_NEVER past the range of time
+    inline uint64_t decay_boundary(const uint64_t lastPeriod, const uint64_t periods, const DecayConfig& config) {
+        const uint64_t start = config.alignToEpoch ? lastPeriod / config.decayPeriod * config.decayPeriod : lastPeriod;
+        if (periods > (DECAY_NEVER - 1 - start) / config.decayPeriod) {
+            return DECAY_NEVER;
+        }
+        return start + periods * config.decayPeriod;
+    }
+
+    struct DecayPoint {
+        uint64_t time;
+        uint64_t balance;
+    };
+
+    /**
+     * Balance at each of the next `count` period boundaries after the
+     * evaluation time, as decay<Policy> would settle it at that boundary from
+     * `currentBalance` and `lastPeriod`. Anchored policies settle to these
+     * points however often the balance is settled in between; the others scale
+     * every point from the current balance, so a settlement in between may
+     * leave later points off by its rounding.
+     */
+    template<typename Policy>
+    std::vector<DecayPoint> project_decay(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const uint64_t count,
+            const DecayAnchor& anchor
+    ) {
+        std::vector<DecayPoint> points;
+        if (config.decayPeriod == 0) {
+            return points;
+        }
+
+        DecayConfig at = config;
+        at.evaluationTime = config.evaluationTime < lastPeriod ? lastPeriod : config.evaluationTime;
+        const uint64_t elapsed = decay_periods(lastPeriod, at).periods;
+
+        points.reserve(count);
+        for (uint64_t i = 1; i <= count; ++i) {
+            at.evaluationTime = decay_boundary(lastPeriod, elapsed + i, config);
+            if (at.evaluationTime == DECAY_NEVER) {
+                break;
+            }
+            points.push_back(DecayPoint{
+                    .time    = at.evaluationTime,
+                    .balance = decay<Policy>(currentBalance, lastPeriod, at, anchor).newBalance
+            });
+        }
+        return points;
+    }
+
+    template<typename Policy>
+    std::vector<DecayPoint> project_decay(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const uint64_t count
+    ) {
+        return project_decay<Policy>(currentBalance, lastPeriod, config, count, DecayAnchor{ currentBalance, lastPeriod });
+    }
+
+    struct DecayCrossing {
+        bool     crosses;
+        uint64_t time;
+    };
+
+    /**
+     * First time at which the balance settles below `threshold`, found in
+     * closed form with Policy::periods_below. The time is a period boundary
+     * and may be before the evaluation time when the balance already fell
+     * below and was not settled since, or `lastPeriod` when it was already
+     * below then. `crosses` is false for a balance that never falls below.
+     */
+    template<typename Policy>
+    const DecayCrossing decay_below(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const uint64_t threshold,
+            const DecayAnchor& anchor
+    ) {
+        if (currentBalance < threshold) {
+            return DecayCrossing{ .crosses = true, .time = lastPeriod };
+        }
+        if (!Policy::decays || config.decayPerPeriod == 0 || config.decayPeriod == 0) {
+            return DecayCrossing{ .crosses = false, .time = 0 };
+        }
+
+        // The anchor is at or above the current balance, so it isn't below either
+        const DecayAnchor from = Policy::anchored ? anchor : DecayAnchor{ currentBalance, lastPeriod };
+        uint64_t periods = Policy::periods_below(from.balance, threshold, config.decayPerPeriod);
+        if (periods == DECAY_NEVER) {
+            return DecayCrossing{ .crosses = false, .time = 0 };
+        }
+        // Settle the floating point error of the solution against `apply`
+        if (periods > 1 && Policy::apply(from.balance, periods - 1, config.decayPerPeriod) < threshold) {
+            --periods;
+        } else if (Policy::apply(from.balance, periods, config.decayPerPeriod) >= threshold) {
+            ++periods;
+        }
+
+        const uint64_t time = decay_boundary(from.period, periods, config);
+        if (time == DECAY_NEVER) {
+            return DecayCrossing{ .crosses = false, .time = 0 };
+        }
+        return DecayCrossing{ .crosses = true, .time = time };
+    }
+
+    template<typename Policy>
+    const DecayCrossing decay_below(
+            const uint64_t currentBalance,
+            const uint64_t lastPeriod,
+            const DecayConfig& config,
+            const uint64_t threshold
+    ) {
+        return decay_below<Policy>(currentBalance, lastPeriod, config, threshold, DecayAnchor{ currentBalance, lastPeriod });
+    }
+
+    // Exponential decay, the policy every token used before policies existed
     const DecayResult decay(
             const uint64_t currentBalance,
             const uint64_t lastPeriod,
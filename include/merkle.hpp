@@ -0,0 +1,136 @@
+#pragma once
+#include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
+#include <tables/account.hpp>
+#include <tables/merkle.hpp>
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/**
+ * Hashing and proofs of the balance commitment kept in merkle.tree/merkle.node.
+ *
+ * leaf = sha256(0x00 | owner | tenant | amount | symbol | last_decay_period)
+ * node = sha256(0x01 | left | right), or zero when both children are zero
+ *
+ * Integers are little endian. A leaf at `index` takes the right branch at
+ * level `l` when bit `l` of `index` is set.
+ */
+namespace hypha::merkle {
+
+    inline checksum256 leaf_hash(const name& owner, const accountv2& account) {
+        char buffer[1 + 5 * sizeof(uint64_t)];
+        const uint64_t fields[5] = {
+            owner.value,
+            account.tenant.value,
+            (uint64_t) account.balance.amount,
+            account.balance.symbol.raw(),
+            account.last_decay_period
+        };
+        buffer[0] = 0;
+        std::memcpy(buffer + 1, fields, sizeof(fields));
+        return eosio::sha256(buffer, sizeof(buffer));
+    }
+
+    inline checksum256 node_hash(const checksum256& left, const checksum256& right) {
+        static const checksum256 empty;
+        if (left == empty && right == empty) {
+            return empty;
+        }
+
+        char buffer[1 + 2 * 32];
+        buffer[0] = 1;
+        std::memcpy(buffer + 1, left.extract_as_byte_array().data(), 32);
+        std::memcpy(buffer + 33, right.extract_as_byte_array().data(), 32);
+        return eosio::sha256(buffer, sizeof(buffer));
+    }
+
+    /**
+     * Leaves written by one action to the commitment of a token, hashed into
+     * the tree together when the action is done with them, so the nodes above
+     * several leaves are rewritten once. Appended leaves take the indices past
+     * tree.leaf_count in order. Without a tree, for a token that isn't
+     * committed, nothing may be added.
+     */
+    class leaf_batch {
+    public:
+        explicit leaf_batch(const merkle_tree* tree) : tree_(tree) {}
+
+        bool committed() const { return tree_ != nullptr; }
+        const merkle_tree& tree() const { return *tree_; }
+        bool empty() const { return leaves_.empty(); }
+
+        // Index the next appended leaf takes
+        uint64_t next_index() const { return tree_->leaf_count + appended_; }
+
+        void append(const checksum256& hash) {
+            leaves_.emplace_back(next_index(), hash);
+            appended_++;
+        }
+
+        void update(uint64_t index, const checksum256& hash) {
+            leaves_.emplace_back(index, hash);
+        }
+
+        std::vector<std::pair<uint64_t, checksum256>> take() {
+            appended_ = 0;
+            return std::move(leaves_);
+        }
+
+    private:
+        const merkle_tree*                            tree_;
+        std::vector<std::pair<uint64_t, checksum256>> leaves_;
+        uint64_t                                      appended_ = 0;
+    };
+
+    struct balance_proof {
+        name                     owner;
+        accountv2                account;
+        uint64_t                 index;
+        std::vector<checksum256> siblings;
+        checksum256              root;
+    };
+
+    inline checksum256 compute_root(const checksum256& leaf, uint64_t index, const std::vector<checksum256>& siblings) {
+        checksum256 current = leaf;
+        for (const auto& sibling : siblings) {
+            current = (index & 1) ? node_hash(sibling, current) : node_hash(current, sibling);
+            index >>= 1;
+        }
+        return current;
+    }
+
+    inline bool verify(const balance_proof& proof) {
+        return compute_root(leaf_hash(proof.owner, proof.account), proof.index, proof.siblings) == proof.root;
+    }
+
+    /**
+     * Reads the inclusion proof of the balance of `owner` from the tables of
+     * `token_contract_account`. Fails if the balance isn't committed yet.
+     */
+    inline balance_proof get_proof(const name& token_contract_account, const name& tenant,
+                                   const name& owner, const symbol_code& code) {
+        accounts accountstable( token_contract_account, owner.value );
+        auto account_index = accountstable.get_index<name("bykey")>();
+        const auto& account = account_index.get( accountv2::build_key(tenant, code), "no balance object found" );
+
+        merkle_leaves leaves( token_contract_account, owner.value );
+        const auto& leaf = leaves.get( account.id, "balance is not committed yet" );
+
+        merkle_trees trees( token_contract_account, code.raw() );
+        auto tree_index = trees.get_index<name("bykey")>();
+        const auto& tree = tree_index.get( merkle_tree::build_key(tenant, code), "token has no commitment" );
+
+        merkle_nodes nodes( token_contract_account, code.raw() );
+        auto by_position = nodes.get_index<name("bypos")>();
+
+        balance_proof proof{ .owner = owner, .account = account, .index = leaf.index, .siblings = {}, .root = tree.root };
+        proof.siblings.reserve(tree.depth);
+        for (uint64_t level = 0, index = leaf.index; level < tree.depth; ++level, index >>= 1) {
+            auto node = by_position.find( merkle_node::build_position(tree.id, level, index ^ 1) );
+            proof.siblings.push_back(node != by_position.end() ? node->hash : checksum256());
+        }
+        return proof;
+    }
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <decay.hpp>
 #include <eosio/eosio.hpp>
 
 namespace hypha {
@@ -11,6 +12,33 @@ namespace hypha {
         name     tenant;
         asset    balance;
         uint64_t last_decay_period;
+        // Anchor of anchored decay policies (see DecayAnchor) and the decay revision
+        // of the token it was set in. Rows without one, or with one of an earlier
+        // revision, decay from their balance at last_decay_period
+        eosio::binary_extension<int64_t>  decay_base;
+        eosio::binary_extension<uint64_t> decay_base_period;
+        eosio::binary_extension<uint64_t> decay_base_revision;
+
+        DecayAnchor decay_anchor(const uint64_t revision) const {
+            const uint64_t base_revision = decay_base_revision.has_value() ? decay_base_revision.value() : 0;
+            if (!decay_base.has_value() || !decay_base_period.has_value() || base_revision != revision) {
+                return DecayAnchor{ .balance = (uint64_t) balance.amount, .period = last_decay_period };
+            }
+            return DecayAnchor{ .balance = (uint64_t) decay_base.value(), .period = decay_base_period.value() };
+        }
+
+        void set_decay_anchor(const DecayAnchor& anchor, const uint64_t revision) {
+            decay_base.emplace(anchor.balance);
+            decay_base_period.emplace(anchor.period);
+            decay_base_revision.emplace(revision);
+        }
+
+        // Restarts anchored decay from the current balance, after any change other than decay
+        void reset_decay_anchor(const uint64_t revision) {
+            if (BuildDecayPolicy::anchored || decay_base.has_value()) {
+                set_decay_anchor(DecayAnchor{ .balance = (uint64_t) balance.amount, .period = last_decay_period }, revision);
+            }
+        }
 
         static uint128_t build_key(const name& tenant, const symbol_code& currency) {
             return ((uint128_t)tenant.value << 64) | currency.raw();
@@ -14,6 +14,24 @@ namespace hypha {
         name     issuer;
         uint64_t decay_per_period_x10M;
         uint64_t decay_period;
+        // Decay periods end on epoch boundaries, see DecayConfig::alignToEpoch
+        eosio::binary_extension<bool> decay_epoch_aligned;
+        // Counts the changes of the decay parameters, decay anchors of balances
+        // (see accountv2) only apply in the revision they were set in
+        eosio::binary_extension<uint64_t> decay_revision;
+
+        uint64_t current_decay_revision() const {
+            return decay_revision.has_value() ? decay_revision.value() : 0;
+        }
+
+        // After any change of decay_period, decay_per_period_x10M or decay_epoch_aligned
+        void next_decay_revision() {
+            // An extension can only be written after the ones before it
+            if (!decay_epoch_aligned.has_value()) {
+                decay_epoch_aligned.emplace(false);
+            }
+            decay_revision.emplace(current_decay_revision() + 1);
+        }
 
         static uint128_t build_key(const name& tenant, const symbol_code& currency) {
             return ((uint128_t)tenant.value << 64) | currency.raw();
@@ -0,0 +1,111 @@
+#pragma once
+#include <eosio/crypto.hpp>
+#include <eosio/eosio.hpp>
+
+namespace hypha {
+    using eosio::checksum256;
+    using eosio::name;
+    using eosio::symbol_code;
+
+    /**
+     * Merkle commitment over the balances of one token, scoped by symbol code
+     * like stat.v2. The tree is `depth` levels high and holds `leaf_count` leaves.
+     * `complete` is set once every balance of the token is known to be committed:
+     * from the start for tokens created with the commitment, after `backfill`
+     * for tokens holding balances written before it.
+     */
+    struct [[eosio::table("merkle.tree"), eosio::contract("voice.hypha")]] merkle_tree {
+        uint64_t    id;
+        name        tenant;
+        symbol_code code;
+        uint64_t    leaf_count;
+        uint64_t    depth;
+        checksum256 root;
+        bool        complete;
+
+        static uint128_t build_key(const name& tenant, const symbol_code& currency) {
+            return ((uint128_t)tenant.value << 64) | currency.raw();
+        }
+
+        uint64_t primary_key() const {
+            return id;
+        }
+
+        uint128_t by_tenant_and_code() const {
+            return build_key(tenant, code);
+        }
+    };
+
+    /**
+     * Node hashes below the root of every tree, scoped by symbol code.
+     * Nodes that were never written are empty and hash to zero.
+     */
+    struct [[eosio::table("merkle.node"), eosio::contract("voice.hypha")]] merkle_node {
+        uint64_t    id;
+        uint128_t   position;
+        checksum256 hash;
+
+        static uint128_t build_position(const uint64_t tree_id, const uint64_t level, const uint64_t index) {
+            return ((uint128_t)tree_id << 64) | (level << 56) | index;
+        }
+
+        uint64_t primary_key() const {
+            return id;
+        }
+
+        uint128_t by_position() const {
+            return position;
+        }
+    };
+
+    /**
+     * Leaf index of a balance, scoped by owner like accounts.v2 and keyed by
+     * the id of the balance row.
+     */
+    struct [[eosio::table("merkle.leaf"), eosio::contract("voice.hypha")]] merkle_leaf {
+        uint64_t account_id;
+        uint64_t index;
+
+        uint64_t primary_key() const {
+            return account_id;
+        }
+    };
+
+    /**
+     * Owner of each leaf, scoped by symbol code, so the holders of a token can
+     * be walked in leaf order. Same position as the leaf node (level 0).
+     */
+    struct [[eosio::table("merkle.owner"), eosio::contract("voice.hypha")]] merkle_owner {
+        uint64_t  id;
+        uint128_t position;
+        name      owner;
+
+        uint64_t primary_key() const {
+            return id;
+        }
+
+        uint128_t by_position() const {
+            return position;
+        }
+    };
+
+    using merkle_trees_by_key = eosio::indexed_by<
+        "bykey"_n,
+        eosio::const_mem_fun<merkle_tree, uint128_t, &merkle_tree::by_tenant_and_code>
+    >;
+    using merkle_trees = eosio::multi_index<"merkle.tree"_n, merkle_tree, merkle_trees_by_key>;
+
+    using merkle_nodes_by_position = eosio::indexed_by<
+        "bypos"_n,
+        eosio::const_mem_fun<merkle_node, uint128_t, &merkle_node::by_position>
+    >;
+    using merkle_nodes = eosio::multi_index<"merkle.node"_n, merkle_node, merkle_nodes_by_position>;
+
+    using merkle_leaves = eosio::multi_index<"merkle.leaf"_n, merkle_leaf>;
+
+    using merkle_owners_by_position = eosio::indexed_by<
+        "bypos"_n,
+        eosio::const_mem_fun<merkle_owner, uint128_t, &merkle_owner::by_position>
+    >;
+    using merkle_owners = eosio::multi_index<"merkle.owner"_n, merkle_owner, merkle_owners_by_position>;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <eosio/asset.hpp>
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+
+namespace hypha {
+    using eosio::asset;
+    using eosio::name;
+
+    /**
+     * Legacy holders waiting to be migrated to accounts.v2, scoped by the
+     * target tenant. Rows are erased once processed.
+     */
+    struct [[eosio::table("migratequeue"), eosio::contract("voice.hypha")]] migration_entry {
+        uint64_t id;
+        name     owner;
+
+        uint64_t primary_key() const {
+            return id;
+        }
+    };
+
+    /**
+     * Counters of the migration into one tenant, scoped by the tenant. Every
+     * queued holder ends up in exactly one of migrated, skipped, missing or
+     * conflicts.
+     */
+    struct [[eosio::table("migration"), eosio::contract("voice.hypha")]] migration_progress {
+        uint64_t queued    = 0;
+        uint64_t migrated  = 0;
+        // Balance in accounts.v2 equal to the legacy one, already migrated
+        uint64_t skipped   = 0;
+        // No legacy balance
+        uint64_t missing   = 0;
+        // Different balance in accounts.v2, left untouched and listed in migconflict
+        uint64_t conflicts = 0;
+    };
+
+    /**
+     * Holders whose accounts.v2 balance differs from their legacy one, scoped
+     * by the tenant, for the contract to resolve e.g. through `migrateacc`.
+     */
+    struct [[eosio::table("migconflict"), eosio::contract("voice.hypha")]] migration_conflict {
+        name  owner;
+        asset legacy;
+        asset balance;
+
+        uint64_t primary_key() const {
+            return owner.value;
+        }
+    };
+
+    using migration_queue = eosio::multi_index<"migratequeue"_n, migration_entry>;
+    using migration_singleton = eosio::singleton<"migration"_n, migration_progress>;
+    using migration_conflicts = eosio::multi_index<"migconflict"_n, migration_conflict>;
+}
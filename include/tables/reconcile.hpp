@@ -0,0 +1,26 @@
+#pragma once
+#include <eosio/eosio.hpp>
+
+namespace hypha {
+
+    /**
+     * Progress of a supply reconciliation, scoped by symbol code and keyed by
+     * the id of the merkle.tree of the token. `total` sums the balances of the
+     * leaves before `cursor` decayed to the time they were visited, and follows
+     * their changes until the run ends. `unsettled` is the part of that decay
+     * a run that doesn't correct left in the balances.
+     */
+    struct [[eosio::table("reconcile"), eosio::contract("voice.hypha")]] reconciliation {
+        uint64_t tree_id;
+        uint64_t cursor;
+        uint64_t holders;
+        int64_t  total;
+        int64_t  unsettled;
+
+        uint64_t primary_key() const {
+            return tree_id;
+        }
+    };
+
+    using reconciliations = eosio::multi_index<"reconcile"_n, reconciliation>;
+}
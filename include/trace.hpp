@@ -0,0 +1,133 @@
+#pragma once
+
+/**
+ * Hot path probes of the tracing build (VOICE_TRACE).
+ *
+ *   VOICE_TRACE_ACTION("transfer");        profile of the enclosing action
+ *   VOICE_TRACE_SCOPE("merkle.commit");    time until the end of the scope
+ *   VOICE_TRACE_EXPR("stats.bykey", expr)  time of one expression, yields its value
+ *
+ * Without VOICE_TRACE the macros expand to nothing (or to `(expr)`), so the
+ * production build carries no trace code at all.
+ *
+ * Every action prints one line when it returns:
+ *
+ *   VOICE_PROFILE {"action":"transfer","ns":1234,"sections":[{"name":"stats.bykey","count":1,"ns":56},...]}
+ *
+ * Section times are inclusive, a section nested in another one counts in
+ * both. Contracts have no clock inside the VM, so a wasm build only reports
+ * counts (all times are 0); the elapsed time of the whole action is in its
+ * action trace. The native harness reports nanoseconds.
+ */
+#ifdef VOICE_TRACE
+#include <eosio/print.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifndef __wasm__
+#include <chrono>
+#endif
+
+namespace hypha::trace {
+
+    inline uint64_t now_ns() {
+#ifdef __wasm__
+        return 0;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    struct section {
+        const char* name;
+        uint32_t    count;
+        uint64_t    ns;
+    };
+
+    struct profile {
+        static constexpr std::size_t MAX_SECTIONS = 16;
+
+        const char*                           action = nullptr;
+        uint32_t                              depth = 0;
+        uint64_t                              start = 0;
+        std::array<section, MAX_SECTIONS>     sections;
+        std::size_t                           size = 0;
+
+        void add(const char* name, const uint64_t ns) {
+            for (std::size_t i = 0; i < size; ++i) {
+                if (sections[i].name == name || std::strcmp(sections[i].name, name) == 0) {
+                    sections[i].count++;
+                    sections[i].ns += ns;
+                    return;
+                }
+            }
+            // Extra sections are dropped rather than failing the action
+            if (size < MAX_SECTIONS) {
+                sections[size++] = section{ name, 1, ns };
+            }
+        }
+
+        void print(const uint64_t ns) const {
+            eosio::print("VOICE_PROFILE {\"action\":\"", action, "\",\"ns\":", ns, ",\"sections\":[");
+            for (std::size_t i = 0; i < size; ++i) {
+                eosio::print(i == 0 ? "" : ",", "{\"name\":\"", sections[i].name,
+                             "\",\"count\":", sections[i].count, ",\"ns\":", sections[i].ns, "}");
+            }
+            eosio::print("]}\n");
+        }
+    };
+
+    inline profile& current() {
+        static profile p;
+        return p;
+    }
+
+    // Actions called from other actions add to the profile of the outer one
+    class action_probe {
+    public:
+        explicit action_probe(const char* action) {
+            auto& p = current();
+            if (p.depth++ == 0) {
+                p.action = action;
+                p.size = 0;
+                p.start = now_ns();
+            }
+        }
+
+        ~action_probe() {
+            auto& p = current();
+            if (--p.depth == 0) {
+                p.print(now_ns() - p.start);
+            }
+        }
+    };
+
+    class section_probe {
+    public:
+        explicit section_probe(const char* name) : _name(name), _start(now_ns()) {}
+
+        ~section_probe() { current().add(_name, now_ns() - _start); }
+
+    private:
+        const char* _name;
+        uint64_t    _start;
+    };
+}
+
+#define VOICE_TRACE_CONCAT_(a, b) a##b
+#define VOICE_TRACE_CONCAT(a, b) VOICE_TRACE_CONCAT_(a, b)
+
+#define VOICE_TRACE_ACTION(action) \
+    hypha::trace::action_probe VOICE_TRACE_CONCAT(voice_trace_action_, __LINE__)(action)
+#define VOICE_TRACE_SCOPE(name) \
+    hypha::trace::section_probe VOICE_TRACE_CONCAT(voice_trace_section_, __LINE__)(name)
+#define VOICE_TRACE_EXPR(name, ...) \
+    ([&]() -> decltype(auto) { hypha::trace::section_probe probe(name); return __VA_ARGS__; }())
+#else
+#define VOICE_TRACE_ACTION(action)
+#define VOICE_TRACE_SCOPE(name)
+#define VOICE_TRACE_EXPR(name, ...) (__VA_ARGS__)
+#endif
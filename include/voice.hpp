@@ -2,9 +2,15 @@
 
 #include <eosio/asset.hpp>
 #include <eosio/eosio.hpp>
+#include <decay.hpp>
+#include <merkle.hpp>
 #include <tables/account.hpp>
 #include <tables/currency_stats.hpp>
+#include <tables/merkle.hpp>
+#include <tables/migration.hpp>
+#include <tables/reconcile.hpp>
 
+#include <algorithm>
 #include <string>
 
 namespace hypha {
@@ -12,6 +18,48 @@ namespace hypha {
     using namespace eosio;
     using namespace std;
 
+    constexpr uint64_t DECAY_PER_PERIOD_X10M = 10000000;
+
+    // Most period boundaries projected by one `decaycurve` call
+    constexpr uint64_t MAX_DECAY_POINTS = 1000;
+
+    /**
+     * Voting weight of each voter (in the order they were given) and their sum.
+     */
+    struct vote_tally {
+        std::vector<asset> weights;
+        asset              total;
+    };
+
+    /**
+     * Balance a holder will be settled to at the end of a decay period.
+     */
+    struct decay_point {
+        uint64_t time;
+        asset    balance;
+    };
+
+    /**
+     * When a balance falls below a threshold, `crosses` is false if it never does.
+     */
+    struct decay_crossing {
+        bool     crosses;
+        uint64_t time;
+    };
+
+    /**
+     * Outcome of one page of `reconcile`: `holders` visited so far, the sum of
+     * their decayed balances and the supply after this page, less the decay left
+     * unsettled in them. The run is over when `done`.
+     */
+    struct reconcile_status {
+        uint64_t cursor;
+        uint64_t holders;
+        asset    total;
+        asset    supply;
+        bool     done;
+    };
+
     /**
     * eosio.token contract defines the structures and actions that allow users to create, issue, and manage
     * tokens on EOSIO based blockchains.
@@ -35,6 +83,32 @@ class [[eosio::contract("voice.hypha")]] voice : public eosio::contract {
         [[eosio::action]]
         void migrateacc(const name& tenant, const std::vector<name> accounts);
 
+        /**
+        * Queues legacy holders for `migrate`, e.g. the scopes of the old accounts
+        * table as listed by get_table_by_scope. Can be called as many times as needed.
+        * @param tenant target tenant to put the results in
+        * @param accounts Accounts to migrate
+        */
+        [[eosio::action]]
+        void migqueue(const name& tenant, const std::vector<name>& accounts);
+
+        /**
+        * Migrates up to `max_accounts` queued holders to the multitenant table
+        * (account_v2). A holder whose balance there equals the legacy one is
+        * skipped, an empty balance, e.g. from `open`, receives the legacy one.
+        * Any other balance is left as is and reported as a conflict in
+        * migconflict. Calls resume where the previous one stopped.
+        * @param tenant target tenant to put the results in
+        * @param max_accounts Queued holders to process in this call
+        * @return migration_progress counters of the whole migration so far
+        */
+        [[eosio::action]]
+        migration_progress migrate(const name& tenant, const uint64_t max_accounts);
+
+        /**
+        * Deletes a token. Its merkle commitment goes with it, which needs every
+        * leaf to be uncommitted first, see `setcommit`.
+        */
         [[eosio::action]]
         void del(const name& tenant, const asset&   symbol);
 
@@ -114,6 +188,37 @@ class [[eosio::contract("voice.hypha")]] voice : public eosio::contract {
         // Runs decaying actions
         ACTION decay(const name& tenant, const name& owner, symbol symbol);
 
+        /**
+         * Turns the merkle commitment of a token's balances (see merkle.hpp) on
+         * or off. Tokens aren't committed by default: keeping the root up to date
+         * costs every balance write a path of hashes and node rows, and each
+         * holder the RAM of its leaf. A token with supply is only complete once
+         * its existing balances are committed with `backfill`. Turning it off
+         * needs every leaf to be uncommitted first, e.g. by `close` or `delbal`.
+         *
+         * @param tenant Owner tenant of the token
+         * @param symbol Symbol of the token
+         * @param enabled Whether balance writes keep the commitment up to date
+         */
+        [[eosio::action]]
+        void setcommit(const name& tenant, const symbol& symbol, const bool enabled);
+
+        /**
+         * Adds the balances of `owners` written before the commitment existed to
+         * the merkle commitment, at the expense of the contract. Balances already
+         * committed and owners without a balance are skipped. Any authorized
+         * write to a balance commits it as well, billed to the payer of the write.
+         *
+         * @param tenant Owner tenant of the token
+         * @param symbol Symbol of the token
+         * @param owners Holders whose balances to commit
+         * @param complete Marks every balance of the token as committed, once the
+         *                 holders from before the commitment are all backfilled.
+         *                 Needed for `reconcile` to correct the supply
+         */
+        [[eosio::action]]
+        void backfill(const name& tenant, const symbol& symbol, const std::vector<name>& owners, const bool complete);
+
         /**
          * @brief Edits the decay config values
          * 
@@ -125,6 +230,19 @@ class [[eosio::contract("voice.hypha")]] voice : public eosio::contract {
          */
         ACTION moddecay(const name& tenant, symbol symbol, uint64_t new_decay_period, uint64_t new_decay_per_periox_x10m);
 
+        /**
+         * @brief Aligns the decay periods of a token to the epoch: periods end on
+         * multiples of `decay_period` since the unix epoch, the same instant for
+         * every holder, instead of `decay_period` after each holder's last decay.
+         * A balance last decayed in the middle of a period then decays on the next
+         * boundary.
+         *
+         * @param tenant Owner tenant of the token
+         * @param symbol Symbol of the token
+         * @param aligned Whether periods are aligned to the epoch
+         */
+        ACTION aligndecay(const name& tenant, const symbol& symbol, const bool aligned);
+
         /**
          * Allows `ram_payer` to create an account `owner` with zero balance for
          * token `symbol` at the expense of `ram_payer`.
@@ -139,6 +257,21 @@ class [[eosio::contract("voice.hypha")]] voice : public eosio::contract {
         [[eosio::action]]
         void open(const name& tenant, const name& owner, const symbol& symbol, const name& ram_payer);
 
+        /**
+         * Bulk `open`: creates the missing zero balances of `owners` at the expense
+         * of `ram_payer`, validating the token once. Owners that already have a
+         * balance are skipped.
+         *
+         * @param owners - the accounts to be created,
+         * @param symbol - the token to be payed with by `ram_payer`,
+         * @param ram_payer - the account that supports the cost of this action,
+         * @param commit - whether to add the new balances to the merkle commitment,
+         * if the token has one,
+         * now, in one pass, instead of on their first update.
+         */
+        [[eosio::action]]
+        void openmany(const name& tenant, const symbol& symbol, const std::vector<name>& owners, const name& ram_payer, const bool commit);
+
         /**
          * This action is the opposite for open, it closes the account `owner`
          * for token `symbol`.
@@ -168,14 +301,209 @@ class [[eosio::contract("voice.hypha")]] voice : public eosio::contract {
             return ac.balance;
         }
 
+        /**
+         * Projects the balance of every voter to `timestamp` with the token decay,
+         * without writing anything. Meant to total the voice behind a proposal
+         * in one call instead of decaying each voter first.
+         *
+         * @param tenant Owner tenant of the token
+         * @param symbol Symbol of the token
+         * @param voters Accounts to weigh, voters without a balance weigh zero. A voter
+         *               listed twice fails the action instead of being counted twice
+         * @param timestamp Seconds since epoch to evaluate the decay at, 0 for the current time
+         * @return vote_tally 
+         */
+        [[eosio::action]]
+        vote_tally tally(const name& tenant, const symbol& symbol, const std::vector<name>& voters, const uint64_t timestamp);
+
+        /**
+         * Projects the balance of `owner` to each of the next `periods` decay
+         * period boundaries after `timestamp`, without writing anything. Each
+         * point is what `decay` would settle the balance to at that time if it
+         * doesn't change before.
+         *
+         * @param tenant Owner tenant of the token
+         * @param owner Holder of the balance
+         * @param symbol Symbol of the token
+         * @param periods Boundaries to project, at most MAX_DECAY_POINTS
+         * @param timestamp Seconds since epoch to project from, 0 for the current time
+         * @return std::vector<decay_point>
+         */
+        [[eosio::action]]
+        std::vector<decay_point> decaycurve(const name& tenant, const name& owner, const symbol& symbol,
+                                            const uint64_t periods, const uint64_t timestamp);
+
+        /**
+         * Finds the time the balance of `owner` decays below `threshold`, solved
+         * in closed form from the decay policy of the token, without writing
+         * anything. The time is the period boundary at which `decay` settles the
+         * balance below the threshold if it doesn't change before; it is before
+         * `timestamp` for a balance already below by then.
+         *
+         * @param tenant Owner tenant of the token
+         * @param owner Holder of the balance
+         * @param threshold Balance to fall below
+         * @param timestamp Seconds since epoch to evaluate at, 0 for the current time
+         * @return decay_crossing
+         */
+        [[eosio::action]]
+        decay_crossing decaybelow(const name& tenant, const name& owner, const asset& threshold, const uint64_t timestamp);
+
+        /**
+         * Checks that the supply of a token equals the sum of its balances, a page
+         * of at most `max_holders` holders per call. Holders are walked in the
+         * order of the merkle commitment and the sum is of their balances decayed
+         * to now. Only a run that corrects settles that decay on the way, any
+         * other one writes nothing but its progress and compares the sum to the
+         * supply the settlement would leave. Balances that change behind the
+         * cursor during the run are followed. The run ends when every leaf was
+         * visited, the progress is then cleared.
+         *
+         * Balances written before the commitment existed aren't walked until they
+         * are committed, see `backfill`. Until the commitment is complete the sum
+         * can miss some of them, so the supply is never corrected.
+         *
+         * @param tenant Owner tenant of the token
+         * @param symbol Symbol of the token
+         * @param max_holders Holders to visit in this call, bounds its CPU
+         * @param correct Set the supply to the sum of the balances when the run ends,
+         *                fails while the commitment isn't complete
+         * @return reconcile_status
+         */
+        [[eosio::action]]
+        reconcile_status reconcile(const name& tenant, const symbol& symbol, const uint64_t max_holders, const bool correct);
+
+        /**
+         * Calls `fn` with the decay policy of a token: tokens without decay
+         * parameters never decay, any other token uses the policy of the build.
+         */
+        template<typename Fn>
+        static auto with_decay_policy(const currency_statsv2& st, Fn&& fn)
+        {
+            if (!BuildDecayPolicy::decays || st.decay_per_period_x10M == 0 || st.decay_period == 0) {
+                return fn(NoDecay{});
+            }
+            return fn(BuildDecayPolicy{});
+        }
+
+        static DecayConfig get_decay_config(const currency_statsv2& st, const uint64_t evaluation_time)
+        {
+            return DecayConfig{
+                .decayPeriod    = st.decay_period,
+                .evaluationTime = evaluation_time,
+                .decayPerPeriod = st.decay_per_period_x10M / (double) DECAY_PER_PERIOD_X10M,
+                .alignToEpoch   = st.decay_epoch_aligned.has_value() && st.decay_epoch_aligned.value()
+            };
+        }
+
+        static vote_tally get_vote_weights(const name& tenant, const name& token_contract_account, const symbol& symbol,
+                                           const std::vector<name>& voters, const uint64_t timestamp)
+        {
+            stats statstable( token_contract_account, symbol.code().raw() );
+            auto index = statstable.get_index<name("bykey")>();
+            const auto& st = index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" );
+            check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+            std::vector<name> sorted(voters);
+            std::sort(sorted.begin(), sorted.end());
+            check( std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end(), "duplicate voter" );
+
+            const DecayConfig config = get_decay_config(st, timestamp);
+            const auto key = accountv2::build_key(tenant, symbol.code());
+
+            vote_tally tally{ .weights = {}, .total = asset{0, symbol} };
+            tally.weights.reserve(voters.size());
+            with_decay_policy(st, [&](auto policy) {
+                DecayFactors<decltype(policy)> factors(config);
+                for (const auto& voter : voters) {
+                    accounts accountstable( token_contract_account, voter.value );
+                    auto account_index = accountstable.get_index<name("bykey")>();
+                    auto it = account_index.find( key );
+
+                    asset weight{0, symbol};
+                    if (it != account_index.end()) {
+                        weight.amount = factors.decay(it->balance.amount, it->last_decay_period, it->decay_anchor(st.current_decay_revision())).newBalance;
+                    }
+                    tally.weights.push_back(weight);
+                    tally.total += weight;
+                }
+            });
+            return tally;
+        }
+
+        static std::vector<decay_point> get_decay_curve(const name& tenant, const name& token_contract_account, const name& owner,
+                                                        const symbol& symbol, const uint64_t periods, const uint64_t timestamp)
+        {
+            stats statstable( token_contract_account, symbol.code().raw() );
+            auto index = statstable.get_index<name("bykey")>();
+            const auto& st = index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" );
+            check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+            accounts accountstable( token_contract_account, owner.value );
+            auto account_index = accountstable.get_index<name("bykey")>();
+            const auto& ac = account_index.get( accountv2::build_key(tenant, symbol.code()), "no balance object found" );
+
+            std::vector<decay_point> curve;
+            with_decay_policy(st, [&](auto policy) {
+                for (const auto& point : project_decay<decltype(policy)>(ac.balance.amount, ac.last_decay_period,
+                                                                            get_decay_config(st, timestamp), periods,
+                                                                            ac.decay_anchor(st.current_decay_revision()))) {
+                    curve.push_back(decay_point{ .time = point.time, .balance = asset{int64_t(point.balance), symbol} });
+                }
+            });
+            return curve;
+        }
+
+        static decay_crossing get_decay_crossing(const name& tenant, const name& token_contract_account, const name& owner,
+                                                 const asset& threshold, const uint64_t timestamp)
+        {
+            const auto code = threshold.symbol.code();
+            stats statstable( token_contract_account, code.raw() );
+            auto index = statstable.get_index<name("bykey")>();
+            const auto& st = index.get( currency_statsv2::build_key(tenant, code), "symbol does not exist" );
+            check( st.supply.symbol == threshold.symbol, "symbol precision mismatch" );
+
+            accounts accountstable( token_contract_account, owner.value );
+            auto account_index = accountstable.get_index<name("bykey")>();
+            const auto& ac = account_index.get( accountv2::build_key(tenant, code), "no balance object found" );
+
+            return with_decay_policy(st, [&](auto policy) {
+                const DecayCrossing crossing = decay_below<decltype(policy)>(
+                        ac.balance.amount, ac.last_decay_period, get_decay_config(st, timestamp), threshold.amount,
+                        ac.decay_anchor(st.current_decay_revision()));
+                return decay_crossing{ .crosses = crossing.crosses, .time = crossing.time };
+            });
+        }
+
         using create_action = eosio::action_wrapper<"create"_n, &voice::create>;
         using issue_action = eosio::action_wrapper<"issue"_n, &voice::issue>;
         using open_action = eosio::action_wrapper<"open"_n, &voice::open>;
         using close_action = eosio::action_wrapper<"close"_n, &voice::close>;
+        using reconcile_action = eosio::action_wrapper<"reconcile"_n, &voice::reconcile>;
+        using openmany_action = eosio::action_wrapper<"openmany"_n, &voice::openmany>;
     private:
 
-        void sub_balance(const name& tenant, const name& owner, const asset& value );
-        void add_balance(const name& tenant, const name& owner, const asset& value, const name& ram_payer );
+        void sub_balance(const name& tenant, const name& owner, const asset& value, const currency_statsv2& st );
+        void add_balance(const name& tenant, const name& owner, const asset& value, const name& ram_payer, const currency_statsv2& st );
+        template<typename Policy>
+        bool decay_balance(const name& tenant, const name& owner, const currency_statsv2& st, const name& ram_payer);
+
+        // Keeps merkle.tree in sync with a balance row, see merkle.hpp. `change` is
+        // the change of the balance amount since it was last committed. The rows a
+        // balance needs to join the commitment are billed to `ram_payer`; with no
+        // payer, as in unauthenticated actions, an uncommitted balance stays so
+        void commit_balance(const name& owner, const accountv2& account, const int64_t change, const name& ram_payer);
+        void uncommit_balance(const name& owner, const accountv2& account);
+        void add_merkle_owner(const merkle_tree& tree, const uint64_t index, const name& owner, const name& ram_payer);
+        void reconcile_change(const merkle_tree& tree, const uint64_t index, const int64_t change);
+        const merkle_tree* find_merkle_tree(merkle_trees& trees, const name& tenant, const symbol_code& code);
+        void drop_merkle_tree(merkle_trees& trees, const merkle_tree& tree);
+        void set_merkle_leaf(merkle_trees& trees, const merkle_tree& tree, const uint64_t index, const checksum256& hash,
+                             const name& ram_payer);
+        void append_merkle_leaf(merkle::leaf_batch& batch, const name& owner, const accountv2& account, const name& ram_payer);
+        void commit_merkle_leaves(merkle_trees& trees, merkle::leaf_batch& batch, const name& ram_payer);
+        void set_merkle_leaves(merkle_trees& trees, const merkle_tree& tree, std::vector<std::pair<uint64_t, checksum256>> leaves,
+                               const name& ram_payer);
         void update_issued(const name& tenant, const asset& quantity);
 
         static uint64_t get_current_time();
@@ -2,12 +2,14 @@
 #include <decay.hpp>
 #include <eosio/system.hpp>
 #include <tables/old_voice.hpp>
+#include <trace.hpp>
 
-namespace hypha {
+#include <algorithm>
 
-    constexpr uint64_t DECAY_PER_PERIOD_X10M = 10000000;
+namespace hypha {
 
     void voice::migratestat(const name& tenant) {
+        VOICE_TRACE_ACTION("migratestat");
         require_auth( get_self() );
         eosio::symbol_code hvoice_symbol_code("HVOICE");
 
@@ -36,6 +38,7 @@ namespace hypha {
     }
 
     void voice::migrateacc(const name& tenant, const std::vector<name> accounts) {
+        VOICE_TRACE_ACTION("migrateacc");
         require_auth( get_self() );
         eosio::symbol_code hvoice_symbol_code("HVOICE");
 
@@ -53,20 +56,136 @@ namespace hypha {
 
             auto existingInNewAccount = index.find( accountv2::build_key(tenant, hvoice_symbol_code) );
             if (existingInNewAccount != index.end()) {
+                uncommit_balance(account_name, *existingInNewAccount);
                 index.erase(existingInNewAccount);
             }
 
-            new_accounts.emplace(get_self(), [&](auto& a) {
+            const auto& migrated = *new_accounts.emplace(get_self(), [&](auto& a) {
                 a.id                = new_accounts.available_primary_key();
                 a.tenant            = tenant;
                 a.balance           = old_account->balance;
                 a.last_decay_period = old_account->last_decay_period;
             });
+            commit_balance(account_name, migrated, migrated.balance.amount, get_self());
+        }
+    }
+
+    void voice::migqueue(const name& tenant, const std::vector<name>& accounts)
+    {
+        VOICE_TRACE_ACTION("migqueue");
+        require_auth( get_self() );
+
+        migration_queue queue( get_self(), tenant.value );
+        for (const auto& account_name : accounts) {
+            queue.emplace( get_self(), [&]( auto& e ) {
+                e.id = queue.available_primary_key();
+                e.owner = account_name;
+            });
+        }
+
+        migration_singleton progress( get_self(), tenant.value );
+        auto counters = progress.get_or_default();
+        counters.queued += accounts.size();
+        progress.set( counters, get_self() );
+    }
+
+    migration_progress voice::migrate(const name& tenant, const uint64_t max_accounts)
+    {
+        VOICE_TRACE_ACTION("migrate");
+        require_auth( get_self() );
+        check( max_accounts > 0, "max_accounts must be positive" );
+        eosio::symbol_code hvoice_symbol_code("HVOICE");
+
+        migration_singleton progress( get_self(), tenant.value );
+        auto counters = progress.get_or_default();
+        const auto key = accountv2::build_key(tenant, hvoice_symbol_code);
+
+        stats statstable( get_self(), hvoice_symbol_code.raw() );
+        auto stat_index = statstable.get_index<name("bykey")>();
+        const auto token = stat_index.find( currency_statsv2::build_key(tenant, hvoice_symbol_code) );
+        const uint64_t decay_revision = token != stat_index.end() ? token->current_decay_revision() : 0;
+
+        // New balances join the commitment together at the end of the page, with
+        // the balances opened before the migration that already had a leaf
+        merkle_trees trees( get_self(), hvoice_symbol_code.raw() );
+        merkle::leaf_batch batch( find_merkle_tree(trees, tenant, hvoice_symbol_code) );
+
+        migration_queue queue( get_self(), tenant.value );
+        auto entry = queue.begin();
+        for (uint64_t processed = 0; entry != queue.end() && processed < max_accounts; ++processed) {
+            const name account_name = entry->owner;
+            entry = queue.erase(entry);
+
+            old_voice::accounts old_accounts(get_self(), account_name.value);
+            const auto old_account = old_accounts.find( hvoice_symbol_code.raw() );
+            if (old_account == old_accounts.end()) {
+                counters.missing++;
+                continue;
+            }
+
+            hypha::accounts new_accounts(get_self(), account_name.value);
+            auto index = new_accounts.get_index<name("bykey")>();
+            const auto existing = VOICE_TRACE_EXPR("accounts.bykey", index.find( key ));
+            if (existing != index.end()) {
+                if (existing->balance == old_account->balance && existing->last_decay_period == old_account->last_decay_period) {
+                    counters.skipped++;
+                } else if (existing->balance.amount == 0) {
+                    // Opened before the migration, the contract takes over the row
+                    VOICE_TRACE_EXPR("accounts.write", index.modify( existing, get_self(), [&]( auto& a ) {
+                        a.balance = old_account->balance;
+                        a.last_decay_period = old_account->last_decay_period;
+                        a.reset_decay_anchor(decay_revision);
+                    }));
+                    if (batch.committed()) {
+                        merkle_leaves leaves( get_self(), account_name.value );
+                        const auto leaf = leaves.find( existing->id );
+                        if (leaf == leaves.end()) {
+                            append_merkle_leaf(batch, account_name, *existing, get_self());
+                        } else {
+                            reconcile_change(batch.tree(), leaf->index, old_account->balance.amount);
+                            batch.update(leaf->index, VOICE_TRACE_EXPR("merkle.hash", merkle::leaf_hash(account_name, *existing)));
+                        }
+                    }
+                    counters.migrated++;
+                } else {
+                    migration_conflicts conflicts( get_self(), tenant.value );
+                    auto conflict = conflicts.find( account_name.value );
+                    auto record = [&]( auto& c ) {
+                        c.owner = account_name;
+                        c.legacy = old_account->balance;
+                        c.balance = existing->balance;
+                    };
+                    if (conflict == conflicts.end()) {
+                        conflicts.emplace( get_self(), record );
+                    } else {
+                        conflicts.modify( conflict, same_payer, record );
+                    }
+                    counters.conflicts++;
+                }
+                continue;
+            }
+
+            const auto& migrated = *VOICE_TRACE_EXPR("accounts.write", new_accounts.emplace(get_self(), [&](auto& a) {
+                a.id                = new_accounts.available_primary_key();
+                a.tenant            = tenant;
+                a.balance           = old_account->balance;
+                a.last_decay_period = old_account->last_decay_period;
+            }));
+            if (batch.committed()) {
+                append_merkle_leaf(batch, account_name, migrated, get_self());
+            }
+            counters.migrated++;
         }
+
+        commit_merkle_leaves(trees, batch, get_self());
+
+        progress.set( counters, get_self() );
+        return counters;
     }
 
     void voice::del(const name& tenant, const asset& symbol)
     {
+        VOICE_TRACE_ACTION("del");
         require_auth( get_self() );
         auto sym = symbol.symbol;
         check( sym.is_valid(), "invalid symbol name" );
@@ -74,11 +193,19 @@ namespace hypha {
         auto index = statstable.get_index<name("bykey")>();
         auto existing = index.find( currency_statsv2::build_key(tenant, sym.code()));
         check( existing != index.end(), "token with symbol does not exists" );
+
+        // A token created again must not pick up the commitment of this one
+        merkle_trees trees( get_self(), sym.code().raw() );
+        const merkle_tree* tree = find_merkle_tree(trees, tenant, sym.code());
+        if (tree != nullptr) {
+            drop_merkle_tree(trees, *tree);
+        }
         index.erase(existing);
     }
 
     void voice::delbal(const name& tenant, const name& account, const symbol& symbol)
     {
+        VOICE_TRACE_ACTION("delbal");
         eosio::check( 
             eosio::has_auth(get_self()) || 
             eosio::has_auth(account),
@@ -89,9 +216,9 @@ namespace hypha {
 
         accounts a_t( get_self(), account.value );
         auto accountByKey = a_t.get_index<name("bykey")>();
-        auto accIt = accountByKey.find(
+        auto accIt = VOICE_TRACE_EXPR("accounts.bykey", accountByKey.find(
             accountv2::build_key(tenant, symbol.code())
-        );
+        ));
 
         check(
             accIt != accountByKey.end(),
@@ -100,20 +227,21 @@ namespace hypha {
 
         stats s_t( get_self(), symbol.code().raw() );
         auto statByKey = s_t.get_index<name("bykey")>();
-        auto statIt = statByKey.find(
+        auto statIt = VOICE_TRACE_EXPR("stats.bykey", statByKey.find(
             currency_statsv2::build_key(tenant, symbol.code())
-        );
+        ));
 
         check(
             statIt != statByKey.end(),
             "token of specified symbol and tenant does not exist"
         );
 
-        statByKey.modify( statIt, same_payer, [&]( currency_statsv2& s ) {
+        VOICE_TRACE_EXPR("stats.modify", statByKey.modify( statIt, same_payer, [&]( currency_statsv2& s ) {
             s.supply -= accIt->balance;
-        });
+        }));
 
-        accountByKey.erase(accIt);
+        uncommit_balance(account, *accIt);
+        VOICE_TRACE_EXPR("accounts.write", accountByKey.erase(accIt));
     }
 
     void voice::create( const name&    tenant,
@@ -122,6 +250,7 @@ namespace hypha {
                         const uint64_t decay_period,
                         const uint64_t decay_per_period_x10M )
     {
+        VOICE_TRACE_ACTION("create");
         require_auth( get_self() );
 
         auto sym = maximum_supply.symbol;
@@ -129,6 +258,7 @@ namespace hypha {
         check( maximum_supply.is_valid(), "invalid supply");
         check( decay_period >= 0, "invalid decay_period");
         check( decay_per_period_x10M >= 0 && decay_per_period_x10M <= DECAY_PER_PERIOD_X10M, "decay_per_period_x10M must be between 0 and 10,000,000");
+        check( BuildDecayPolicy::decays || decay_per_period_x10M == 0, "decaying tokens are not supported by this build");
         // remove this check because we allow -1 to be used for the max supply of a mintable token
         //  check( maximum_supply.amount > 0, "max-supply must be positive");
 
@@ -152,13 +282,14 @@ namespace hypha {
 
     void voice::issue(const name& tenant, const name& to, const asset& quantity, const string& memo)
     {
+        VOICE_TRACE_ACTION("issue");
         auto sym = quantity.symbol;
         check( sym.is_valid(), "invalid symbol name" );
         check( memo.size() <= 256, "memo has more than 256 bytes" );
 
         stats statstable( get_self(), sym.code().raw() );
         auto index = statstable.get_index<name("bykey")>();
-        auto existing = index.find( currency_statsv2::build_key(tenant, sym.code()) );
+        auto existing = VOICE_TRACE_EXPR("stats.bykey", index.find( currency_statsv2::build_key(tenant, sym.code()) ));
         check( existing != index.end(), "token with symbol does not exist, create token before issue" );
         const auto& st = *existing;
         check( to == st.issuer, "tokens can only be issued to issuer account" );
@@ -174,11 +305,11 @@ namespace hypha {
             check( quantity.amount <= st.max_supply.amount - st.supply.amount, "quantity exceeds available supply");
         }
 
-        statstable.modify( st, same_payer, [&]( auto& s ) {
+        VOICE_TRACE_EXPR("stats.modify", statstable.modify( st, same_payer, [&]( auto& s ) {
             s.supply += quantity;
-        });
+        }));
 
-        add_balance( tenant, st.issuer, quantity, st.issuer );
+        add_balance( tenant, st.issuer, quantity, st.issuer, st );
     }
 
     void voice::transfer( const name&    tenant,
@@ -187,17 +318,18 @@ namespace hypha {
                           const asset&   quantity,
                           const string&  memo )
     {
+        VOICE_TRACE_ACTION("transfer");
         check( from != to, "cannot transfer to self" );
         require_auth( from );
         check( is_account( to ), "to account does not exist");
         auto sym = quantity.symbol.code();
         stats statstable( get_self(), sym.raw() );
         auto index = statstable.get_index<name("bykey")>();
-        const auto& st = index.get( currency_statsv2::build_key(tenant, sym) );
+        const auto& st = VOICE_TRACE_EXPR("stats.bykey", index.get( currency_statsv2::build_key(tenant, sym) ));
 
         check( from == st.issuer, "tokens can only be transferred by issuer account" );
-        require_recipient( from );
-        require_recipient( to );
+        VOICE_TRACE_EXPR("require_recipient", require_recipient( from ));
+        VOICE_TRACE_EXPR("require_recipient", require_recipient( to ));
 
         check( quantity.is_valid(), "invalid quantity" );
         check( quantity.amount > 0, "must transfer positive quantity" );
@@ -206,8 +338,8 @@ namespace hypha {
 
         auto payer = has_auth( to ) ? to : from;
 
-        sub_balance( tenant, from, quantity );
-        add_balance( tenant, to, quantity, payer );
+        sub_balance( tenant, from, quantity, st );
+        add_balance( tenant, to, quantity, payer, st );
     }
     
     void voice::burn( const name&    tenant,
@@ -215,62 +347,276 @@ namespace hypha {
                           const asset&   quantity,
                           const string&  memo )
     {
+        VOICE_TRACE_ACTION("burn");
         require_auth( from );
         auto sym = quantity.symbol.code();
         stats statstable( get_self(), sym.raw() );
         auto index = statstable.get_index<name("bykey")>();
-        const auto& st = index.get( currency_statsv2::build_key(tenant, sym) );
+        const auto& st = VOICE_TRACE_EXPR("stats.bykey", index.get( currency_statsv2::build_key(tenant, sym) ));
 
-        require_recipient( from );
+        VOICE_TRACE_EXPR("require_recipient", require_recipient( from ));
 
         check( quantity.is_valid(), "invalid quantity" );
         check( quantity.amount > 0, "must burn positive quantity" );
         check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
         check( memo.size() <= 256, "memo has more than 256 bytes" );
 
-        sub_balance( tenant, from, quantity );
+        sub_balance( tenant, from, quantity, st );
         
         update_issued(tenant, -1 * quantity);
     }
 
 
     void voice::decay(const name& tenant, const name& owner, symbol symbol) {
+        VOICE_TRACE_ACTION("decay");
         stats statstable( get_self(), symbol.code().raw() );
         auto index = statstable.get_index<name("bykey")>();
-        auto existing = index.find( currency_statsv2::build_key(tenant, symbol.code()) );
+        auto existing = VOICE_TRACE_EXPR("stats.bykey", index.find( currency_statsv2::build_key(tenant, symbol.code()) ));
         check( existing != index.end(), "token with symbol does not exist, create token before issue" );
 
-        accounts from_acnts(get_self(), owner.value);
-        auto account_index = from_acnts.get_index<name("bykey")>();
-        const auto from = account_index.find( accountv2::build_key(tenant, symbol.code()) );
-        if (from == account_index.end()) {
-            // No balance exists yet, nothing to do
+        // Anyone can decay, so nothing may be billed to the contract here
+        with_decay_policy(*existing, [&](auto policy) {
+            decay_balance<decltype(policy)>(tenant, owner, *existing, name());
+        });
+    }
+
+    void voice::backfill(const name& tenant, const symbol& symbol, const std::vector<name>& owners, const bool complete)
+    {
+        VOICE_TRACE_ACTION("backfill");
+        require_auth( get_self() );
+        check( symbol.is_valid(), "invalid symbol name" );
+
+        const auto key = accountv2::build_key(tenant, symbol.code());
+
+        merkle_trees trees( get_self(), symbol.code().raw() );
+        const merkle_tree* tree = find_merkle_tree(trees, tenant, symbol.code());
+        check( tree != nullptr, "token has no commitment, enable it with setcommit" );
+        merkle::leaf_batch batch( tree );
+
+        for (const auto& owner : owners) {
+            accounts acnts( get_self(), owner.value );
+            auto account_index = acnts.get_index<name("bykey")>();
+            const auto it = VOICE_TRACE_EXPR("accounts.bykey", account_index.find( key ));
+            if (it == account_index.end()) {
+                continue;
+            }
+
+            merkle_leaves leaves( get_self(), owner.value );
+            if (leaves.find( it->id ) != leaves.end()) {
+                continue;
+            }
+
+            append_merkle_leaf(batch, owner, *it, get_self());
+        }
+        commit_merkle_leaves(trees, batch, get_self());
+
+        if (complete) {
+            trees.modify( *tree, same_payer, [&]( auto& t ) {
+                t.complete = true;
+            });
+        }
+    }
+
+    void voice::setcommit(const name& tenant, const symbol& symbol, const bool enabled)
+    {
+        VOICE_TRACE_ACTION("setcommit");
+        require_auth( get_self() );
+        check( symbol.is_valid(), "invalid symbol name" );
+
+        stats statstable( get_self(), symbol.code().raw() );
+        auto index = statstable.get_index<name("bykey")>();
+        const auto& st = index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" );
+        check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+        merkle_trees trees( get_self(), symbol.code().raw() );
+        const merkle_tree* tree = find_merkle_tree(trees, tenant, symbol.code());
+        if (!enabled) {
+            check( tree != nullptr, "token has no commitment" );
+            drop_merkle_tree(trees, *tree);
             return;
         }
 
-        const DecayResult result = hypha::decay(
-                from->balance.amount,
-                from->last_decay_period,
-                DecayConfig{
-                    .decayPeriod    = existing->decay_period,
-                    .decayPerPeriod = existing->decay_per_period_x10M / (double) DECAY_PER_PERIOD_X10M,
-                    .evaluationTime = this->get_current_time()
-                }
-        );
+        check( tree == nullptr, "token is already committed" );
+        // With no supply every balance is empty, the others are committed by backfill
+        trees.emplace( get_self(), [&]( auto& t ) {
+            t.id = trees.available_primary_key();
+            t.tenant = tenant;
+            t.code = symbol.code();
+            t.leaf_count = 0;
+            t.depth = 0;
+            t.complete = st.supply.amount == 0;
+        });
+    }
+
+    // Settles the decay of a balance and commits it, returns whether it changed
+    template<typename Policy>
+    bool voice::decay_balance(const name& tenant, const name& owner, const currency_statsv2& st, const name& ram_payer) {
+        if constexpr (!Policy::decays) {
+            // Balances of tokens that don't decay are never read nor rewritten
+            return false;
+        } else {
+            accounts from_acnts(get_self(), owner.value);
+            auto account_index = from_acnts.get_index<name("bykey")>();
+            const auto from = VOICE_TRACE_EXPR("accounts.bykey", account_index.find( accountv2::build_key(tenant, st.supply.symbol.code()) ));
+            if (from == account_index.end()) {
+                // No balance exists yet, nothing to do
+                return false;
+            }
 
-        if (result.needsUpdate) {
-            eosio::asset updated_issued = from->balance;
-            updated_issued.amount = result.newBalance - updated_issued.amount;
-            update_issued(tenant, updated_issued);
-            account_index.modify( from, get_self(), [&]( auto& a ) {
-                a.balance.amount = result.newBalance;
-                a.last_decay_period = result.newPeriod;
+            const uint64_t revision = st.current_decay_revision();
+            const DecayAnchor anchor = from->decay_anchor(revision);
+            const DecayResult result = VOICE_TRACE_EXPR("decay", hypha::decay<Policy>(
+                    from->balance.amount,
+                    from->last_decay_period,
+                    get_decay_config(st, this->get_current_time()),
+                    anchor
+            ));
+
+            if (result.needsUpdate) {
+                eosio::asset updated_issued = from->balance;
+                updated_issued.amount = result.newBalance - updated_issued.amount;
+                update_issued(tenant, updated_issued);
+                VOICE_TRACE_EXPR("accounts.write", account_index.modify( from, get_self(), [&]( auto& a ) {
+                    a.balance.amount = result.newBalance;
+                    a.last_decay_period = result.newPeriod;
+                    // Later settlements decay from the same anchor
+                    if constexpr (Policy::anchored) {
+                        a.set_decay_anchor(anchor, revision);
+                    }
+                }));
+                commit_balance(owner, *from, updated_issued.amount, ram_payer);
+            }
+            return result.needsUpdate;
+        }
+    }
+
+    vote_tally voice::tally(const name& tenant, const symbol& symbol, const std::vector<name>& voters, const uint64_t timestamp)
+    {
+        VOICE_TRACE_ACTION("tally");
+        check( symbol.is_valid(), "invalid symbol name" );
+        return VOICE_TRACE_EXPR("vote_weights", get_vote_weights(tenant, get_self(), symbol, voters, timestamp == 0 ? get_current_time() : timestamp));
+    }
+
+    std::vector<decay_point> voice::decaycurve(const name& tenant, const name& owner, const symbol& symbol,
+                                               const uint64_t periods, const uint64_t timestamp)
+    {
+        VOICE_TRACE_ACTION("decaycurve");
+        check( symbol.is_valid(), "invalid symbol name" );
+        check( periods <= MAX_DECAY_POINTS, "too many periods" );
+        return get_decay_curve(tenant, get_self(), owner, symbol, periods, timestamp == 0 ? get_current_time() : timestamp);
+    }
+
+    decay_crossing voice::decaybelow(const name& tenant, const name& owner, const asset& threshold, const uint64_t timestamp)
+    {
+        VOICE_TRACE_ACTION("decaybelow");
+        check( threshold.is_valid(), "invalid threshold" );
+        check( threshold.amount >= 0, "threshold must not be negative" );
+        return get_decay_crossing(tenant, get_self(), owner, threshold, timestamp == 0 ? get_current_time() : timestamp);
+    }
+
+    reconcile_status voice::reconcile(const name& tenant, const symbol& symbol, const uint64_t max_holders, const bool correct)
+    {
+        VOICE_TRACE_ACTION("reconcile");
+        require_auth( get_self() );
+        check( symbol.is_valid(), "invalid symbol name" );
+        check( max_holders > 0, "max_holders must be positive" );
+
+        const auto key = currency_statsv2::build_key(tenant, symbol.code());
+        stats statstable( get_self(), symbol.code().raw() );
+        auto index = statstable.get_index<name("bykey")>();
+        const auto& st = VOICE_TRACE_EXPR("stats.bykey", index.get( key, "symbol does not exist" ));
+        check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+        merkle_trees trees( get_self(), symbol.code().raw() );
+        const merkle_tree* committed = find_merkle_tree(trees, tenant, symbol.code());
+        check( committed != nullptr, "token has no commitment, enable it with setcommit" );
+        const auto& tree = *committed;
+        // Balances that aren't committed would be missing from the sum
+        check( !correct || tree.complete, "balances written before the commitment may be uncommitted, backfill them first" );
+
+        reconciliations progress( get_self(), symbol.code().raw() );
+        auto run = progress.find( tree.id );
+        if (run == progress.end()) {
+            run = progress.emplace( get_self(), [&]( auto& r ) {
+                r.tree_id = tree.id;
+                r.cursor = 0;
+                r.holders = 0;
+                r.total = 0;
+                r.unsettled = 0;
             });
         }
+
+        // Leaves of the tree are the level 0 positions, they all sort before level 1
+        merkle_owners owners( get_self(), symbol.code().raw() );
+        auto by_position = owners.get_index<name("bypos")>();
+        const auto leaves_end = merkle_node::build_position(tree.id, 1, 0);
+        auto it = by_position.lower_bound( merkle_node::build_position(tree.id, 0, run->cursor) );
+
+        // Settling only rewrites the visited balance, which is past the stored cursor
+        // so the progress row isn't touched until it is written below
+        reconcile_status status{ .cursor = run->cursor, .holders = run->holders, .total = asset{run->total, symbol},
+                                 .supply = asset{0, symbol}, .done = false };
+        int64_t unsettled = run->unsettled;
+        const DecayConfig config = get_decay_config(st, get_current_time());
+        const uint64_t revision = st.current_decay_revision();
+        for (uint64_t visited = 0; it != by_position.end() && it->position < leaves_end && visited < max_holders; ++visited) {
+            const name owner = it->owner;
+            status.cursor = (uint64_t) it->position + 1;
+            ++it;
+
+            // Only a run that corrects the supply settles, visited balances are committed already
+            if (correct) {
+                with_decay_policy(st, [&](auto policy) {
+                    decay_balance<decltype(policy)>(tenant, owner, st, name());
+                });
+            }
+
+            accounts acnts( get_self(), owner.value );
+            auto account_index = acnts.get_index<name("bykey")>();
+            auto account = VOICE_TRACE_EXPR("accounts.bykey", account_index.find( accountv2::build_key(tenant, symbol.code()) ));
+            if (account != account_index.end()) {
+                const int64_t decayed = with_decay_policy(st, [&](auto policy) {
+                    return VOICE_TRACE_EXPR("decay", hypha::decay<decltype(policy)>(
+                            account->balance.amount, account->last_decay_period, config, account->decay_anchor(revision))).newBalance;
+                });
+                status.total.amount += decayed;
+                unsettled += account->balance.amount - decayed;
+            }
+            status.holders++;
+        }
+        status.done = it == by_position.end() || it->position >= leaves_end;
+
+        // Settling updated the supply through another instance of stat.v2. The
+        // decay left unsettled is still part of it, the reported supply is the
+        // one once it is settled
+        stats current( get_self(), symbol.code().raw() );
+        auto current_index = current.get_index<name("bykey")>();
+        auto token = current_index.find( key );
+        status.supply = token->supply;
+        status.supply.amount -= unsettled;
+
+        if (!status.done) {
+            progress.modify( run, same_payer, [&]( auto& r ) {
+                r.cursor = status.cursor;
+                r.holders = status.holders;
+                r.total = status.total.amount;
+                r.unsettled = unsettled;
+            });
+            return status;
+        }
+
+        progress.erase( run );
+        if (correct && status.supply != status.total) {
+            VOICE_TRACE_EXPR("stats.modify", current_index.modify( token, same_payer, [&]( auto& s ) {
+                s.supply.amount = status.total.amount + unsettled;
+            }));
+        }
+        return status;
     }
 
     void voice::moddecay(const name& tenant, symbol symbol, uint64_t new_decay_period, uint64_t new_decay_per_periox_x10m)
     {
+        VOICE_TRACE_ACTION("moddecay");
         require_auth( get_self() );
         
         stats statstable( get_self(), symbol.code().raw() );
@@ -278,41 +624,68 @@ namespace hypha {
         auto existing = index.find( currency_statsv2::build_key(tenant, symbol.code()) );
         check( existing != index.end(), "token with symbol and tenant does not exist, create token before editing it" );
 
+        check( BuildDecayPolicy::decays || new_decay_per_periox_x10m == 0, "decaying tokens are not supported by this build");
+
         index.modify(existing, same_payer, [&](currency_statsv2& stat) {
             stat.decay_period = new_decay_period;
             stat.decay_per_period_x10M = new_decay_per_periox_x10m;
+            // Anchors decayed at the previous rate restart from the last settlement
+            stat.next_decay_revision();
+        });
+    }
+
+    void voice::aligndecay(const name& tenant, const symbol& symbol, const bool aligned)
+    {
+        VOICE_TRACE_ACTION("aligndecay");
+        require_auth( get_self() );
+
+        stats statstable( get_self(), symbol.code().raw() );
+        auto index = statstable.get_index<name("bykey")>();
+        auto existing = index.find( currency_statsv2::build_key(tenant, symbol.code()) );
+        check( existing != index.end(), "token with symbol and tenant does not exist, create token before editing it" );
+
+        index.modify(existing, same_payer, [&](currency_statsv2& stat) {
+            stat.decay_epoch_aligned.emplace(aligned);
+            stat.next_decay_revision();
         });
     }
 
-    void voice::sub_balance(const name& tenant, const name& owner, const asset& value ) {
+    void voice::sub_balance(const name& tenant, const name& owner, const asset& value, const currency_statsv2& st ) {
         accounts from_acnts( get_self(), owner.value );
         auto index = from_acnts.get_index<name("bykey")>();
 
-        const auto& from = index.get( accountv2::build_key(tenant, value.symbol.code()), "no balance object found" );
+        const auto& from = VOICE_TRACE_EXPR("accounts.bykey", index.get( accountv2::build_key(tenant, value.symbol.code()), "no balance object found" ));
         check( from.balance.amount >= value.amount, "overdrawn balance" );
 
-        from_acnts.modify( from, owner, [&]( auto& a ) {
+        VOICE_TRACE_EXPR("accounts.write", from_acnts.modify( from, owner, [&]( auto& a ) {
             a.balance -= value;
-        });
+            a.reset_decay_anchor(st.current_decay_revision());
+        }));
+        commit_balance(owner, from, -value.amount, owner);
     }
 
-    void voice::add_balance(const name& tenant, const name& owner, const asset& value, const name& ram_payer )
+    void voice::add_balance(const name& tenant, const name& owner, const asset& value, const name& ram_payer, const currency_statsv2& st )
     {
-        this->decay(tenant, owner, value.symbol);
+        with_decay_policy(st, [&](auto policy) {
+            decay_balance<decltype(policy)>(tenant, owner, st, ram_payer);
+        });
         accounts to_acnts( get_self(), owner.value );
         auto index = to_acnts.get_index<name("bykey")>();
-        auto to = index.find( accountv2::build_key(tenant, value.symbol.code()) );
+        auto to = VOICE_TRACE_EXPR("accounts.bykey", index.find( accountv2::build_key(tenant, value.symbol.code()) ));
         if( to == index.end() ) {
-            to_acnts.emplace( ram_payer, [&]( auto& a ){
+            const auto& created = *VOICE_TRACE_EXPR("accounts.write", to_acnts.emplace( ram_payer, [&]( auto& a ){
                 a.id = to_acnts.available_primary_key();
                 a.balance = value;
                 a.tenant = tenant;
                 a.last_decay_period = this->get_current_time();
-            });
+            }));
+            commit_balance(owner, created, value.amount, ram_payer);
         } else {
-            index.modify( to, same_payer, [&]( auto& a ) {
+            VOICE_TRACE_EXPR("accounts.write", index.modify( to, same_payer, [&]( auto& a ) {
                 a.balance += value;
-            });
+                a.reset_decay_anchor(st.current_decay_revision());
+            }));
+            commit_balance(owner, *to, value.amount, ram_payer);
         }
     }
 
@@ -323,51 +696,303 @@ namespace hypha {
 
         stats statstable( get_self(), sym.code().raw() );
         auto index = statstable.get_index<name("bykey")>();
-        auto existing = index.find(currency_statsv2::build_key(tenant, sym.code()));
+        auto existing = VOICE_TRACE_EXPR("stats.bykey", index.find(currency_statsv2::build_key(tenant, sym.code())));
         check( existing != index.end(), "token with symbol does not exist" );
         const auto& st = *existing;
 
         check( quantity.is_valid(), "invalid quantity" );
         check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
 
-        statstable.modify( st, same_payer, [&]( auto& s ) {
+        VOICE_TRACE_EXPR("stats.modify", statstable.modify( st, same_payer, [&]( auto& s ) {
             s.supply += quantity;
-        });
+        }));
     }
 
     void voice::open(const name& tenant, const name& owner, const symbol& symbol, const name& ram_payer)
     {
+        VOICE_TRACE_ACTION("open");
         require_auth( ram_payer );
 
         check( is_account( owner ), "owner account does not exist" );
 
         stats statstable( get_self(), symbol.code().raw() );
         auto index = statstable.get_index<name("bykey")>();
-        const auto& st = index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" );
+        const auto& st = VOICE_TRACE_EXPR("stats.bykey", index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" ));
         check( st.supply.symbol == symbol, "symbol precision mismatch" );
 
         accounts acnts( get_self(), owner.value );
         auto account_index = acnts.get_index<name("bykey")>();
-        auto it = account_index.find( accountv2::build_key(tenant, symbol.code()) );
+        auto it = VOICE_TRACE_EXPR("accounts.bykey", account_index.find( accountv2::build_key(tenant, symbol.code()) ));
         if( it == account_index.end() ) {
-            acnts.emplace( ram_payer, [&]( auto& a ){
+            const auto& created = *VOICE_TRACE_EXPR("accounts.write", acnts.emplace( ram_payer, [&]( auto& a ){
                 a.id = acnts.available_primary_key();
                 a.tenant = tenant;
                 a.balance = asset{0, symbol};
                 a.last_decay_period = this->get_current_time();
-            });
+            }));
+            commit_balance(owner, created, 0, ram_payer);
         }
     }
 
+    void voice::openmany(const name& tenant, const symbol& symbol, const std::vector<name>& owners, const name& ram_payer, const bool commit)
+    {
+        VOICE_TRACE_ACTION("openmany");
+        require_auth( ram_payer );
+
+        stats statstable( get_self(), symbol.code().raw() );
+        auto index = statstable.get_index<name("bykey")>();
+        const auto& st = VOICE_TRACE_EXPR("stats.bykey", index.get( currency_statsv2::build_key(tenant, symbol.code()), "symbol does not exist" ));
+        check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+        const auto key = accountv2::build_key(tenant, symbol.code());
+        const auto now = this->get_current_time();
+
+        merkle_trees trees( get_self(), symbol.code().raw() );
+        merkle::leaf_batch batch( commit ? find_merkle_tree(trees, tenant, symbol.code()) : nullptr );
+
+        for (const auto& owner : owners) {
+            check( is_account( owner ), "owner account does not exist" );
+
+            accounts acnts( get_self(), owner.value );
+            auto account_index = acnts.get_index<name("bykey")>();
+            if( VOICE_TRACE_EXPR("accounts.bykey", account_index.find( key )) != account_index.end() ) {
+                continue;
+            }
+
+            const auto& created = *VOICE_TRACE_EXPR("accounts.write", acnts.emplace( ram_payer, [&]( auto& a ){
+                a.id = acnts.available_primary_key();
+                a.tenant = tenant;
+                a.balance = asset{0, symbol};
+                a.last_decay_period = now;
+            }));
+
+            if (batch.committed()) {
+                append_merkle_leaf(batch, owner, created, ram_payer);
+            }
+        }
+        commit_merkle_leaves(trees, batch, ram_payer);
+    }
+
     void voice::close(const name& tenant, const name& owner, const symbol& symbol )
     {
+        VOICE_TRACE_ACTION("close");
         require_auth( owner );
         accounts acnts( get_self(), owner.value );
         auto index = acnts.get_index<name("bykey")>();
-        auto it = index.find( accountv2::build_key(tenant, symbol.code()) );
+        auto it = VOICE_TRACE_EXPR("accounts.bykey", index.find( accountv2::build_key(tenant, symbol.code()) ));
         check( it != index.end(), "Balance row already deleted or never existed. Action won't have any effect." );
         check( it->balance.amount == 0, "Cannot close because the balance is not zero." );
-        index.erase( it );
+        uncommit_balance(owner, *it);
+        VOICE_TRACE_EXPR("accounts.write", index.erase( it ));
+    }
+
+    void voice::commit_balance(const name& owner, const accountv2& account, const int64_t change, const name& ram_payer)
+    {
+        VOICE_TRACE_SCOPE("merkle.commit");
+        const auto code = account.balance.symbol.code();
+        merkle_trees trees( get_self(), code.raw() );
+        const merkle_tree* committed = find_merkle_tree(trees, account.tenant, code);
+        if (committed == nullptr) {
+            return;
+        }
+        const auto& tree = *committed;
+
+        merkle_leaves leaves( get_self(), owner.value );
+        auto leaf = leaves.find( account.id );
+        if (leaf == leaves.end() && ram_payer.value == 0) {
+            return;
+        }
+
+        if (leaf == leaves.end()) {
+            leaf = leaves.emplace( ram_payer, [&]( auto& l ) {
+                l.account_id = account.id;
+                l.index = tree.leaf_count;
+            });
+            add_merkle_owner(tree, leaf->index, owner, ram_payer);
+        } else if (change != 0) {
+            reconcile_change(tree, leaf->index, change);
+        }
+
+        // Nodes above a committed leaf all exist, rewriting it never needs a payer
+        set_merkle_leaf(trees, tree, leaf->index, VOICE_TRACE_EXPR("merkle.hash", merkle::leaf_hash(owner, account)), ram_payer);
+    }
+
+    void voice::uncommit_balance(const name& owner, const accountv2& account)
+    {
+        VOICE_TRACE_SCOPE("merkle.uncommit");
+        merkle_leaves leaves( get_self(), owner.value );
+        auto leaf = leaves.find( account.id );
+        if (leaf == leaves.end()) {
+            return;
+        }
+
+        const auto code = account.balance.symbol.code();
+        merkle_trees trees( get_self(), code.raw() );
+        auto tree_index = trees.get_index<name("bykey")>();
+        const auto& tree = tree_index.get( merkle_tree::build_key(account.tenant, code), "token has no commitment" );
+
+        reconcile_change(tree, leaf->index, -account.balance.amount);
+
+        merkle_owners owners( get_self(), code.raw() );
+        auto by_position = owners.get_index<name("bypos")>();
+        auto holder = by_position.find( merkle_node::build_position(tree.id, 0, leaf->index) );
+        if (holder != by_position.end()) {
+            by_position.erase(holder);
+        }
+
+        // Leaf indices are not reused, the slot stays empty
+        set_merkle_leaf(trees, tree, leaf->index, checksum256(), name());
+        leaves.erase(leaf);
+    }
+
+    void voice::append_merkle_leaf(merkle::leaf_batch& batch, const name& owner, const accountv2& account, const name& ram_payer)
+    {
+        const uint64_t index = batch.next_index();
+        merkle_leaves leaf_table( get_self(), owner.value );
+        leaf_table.emplace( ram_payer, [&]( auto& l ) {
+            l.account_id = account.id;
+            l.index = index;
+        });
+        add_merkle_owner(batch.tree(), index, owner, ram_payer);
+        batch.append(VOICE_TRACE_EXPR("merkle.hash", merkle::leaf_hash(owner, account)));
+    }
+
+    // Hashes the leaves of `batch` into its tree, nodes that don't exist yet are billed to `ram_payer`
+    void voice::commit_merkle_leaves(merkle_trees& trees, merkle::leaf_batch& batch, const name& ram_payer)
+    {
+        if (batch.empty()) {
+            return;
+        }
+        VOICE_TRACE_SCOPE("merkle.commit");
+        set_merkle_leaves(trees, batch.tree(), batch.take(), ram_payer);
+    }
+
+    void voice::add_merkle_owner(const merkle_tree& tree, const uint64_t index, const name& owner, const name& ram_payer)
+    {
+        merkle_owners owners( get_self(), tree.code.raw() );
+        owners.emplace( ram_payer, [&]( auto& o ) {
+            o.id = owners.available_primary_key();
+            o.position = merkle_node::build_position(tree.id, 0, index);
+            o.owner = owner;
+        });
+    }
+
+    // Follows a change of a balance that a running reconciliation already counted
+    void voice::reconcile_change(const merkle_tree& tree, const uint64_t index, const int64_t change)
+    {
+        reconciliations progress( get_self(), tree.code.raw() );
+        auto run = progress.find( tree.id );
+        if (run != progress.end() && index < run->cursor) {
+            progress.modify( run, same_payer, [&]( auto& r ) {
+                r.total += change;
+            });
+        }
+    }
+
+    // Commitment of a token, nullptr for tokens that aren't committed
+    const merkle_tree* voice::find_merkle_tree(merkle_trees& trees, const name& tenant, const symbol_code& code)
+    {
+        auto tree_index = trees.get_index<name("bykey")>();
+        auto tree = VOICE_TRACE_EXPR("merkle.tree", tree_index.find( merkle_tree::build_key(tenant, code) ));
+        return tree != tree_index.end() ? &*tree : nullptr;
+    }
+
+    // Removes a commitment whose leaves were all uncommitted, with its reconciliation
+    void voice::drop_merkle_tree(merkle_trees& trees, const merkle_tree& tree)
+    {
+        check( tree.root == checksum256(), "the commitment still has leaves, close or delete their balances first" );
+        reconciliations progress( get_self(), tree.code.raw() );
+        auto run = progress.find( tree.id );
+        if (run != progress.end()) {
+            progress.erase( run );
+        }
+        trees.erase( tree );
+    }
+
+    void voice::set_merkle_leaf(merkle_trees& trees, const merkle_tree& tree, const uint64_t index, const checksum256& hash,
+                                const name& ram_payer)
+    {
+        set_merkle_leaves(trees, tree, { { index, hash } }, ram_payer);
+    }
+
+    // `leaves` are (index, hash) pairs with distinct indices, every node above them is rewritten once.
+    // Nodes that don't exist yet are billed to `ram_payer`
+    void voice::set_merkle_leaves(merkle_trees& trees, const merkle_tree& tree, std::vector<std::pair<uint64_t, checksum256>> leaves,
+                                  const name& ram_payer)
+    {
+        if (leaves.empty()) {
+            return;
+        }
+        std::sort(leaves.begin(), leaves.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        merkle_nodes nodes( get_self(), tree.code.raw() );
+        auto by_position = nodes.get_index<name("bypos")>();
+        const checksum256 empty;
+
+        auto get_node = [&](uint64_t level, uint64_t position) {
+            VOICE_TRACE_SCOPE("merkle.nodes");
+            auto it = by_position.find( merkle_node::build_position(tree.id, level, position) );
+            return it != by_position.end() ? it->hash : empty;
+        };
+
+        auto set_node = [&](uint64_t level, uint64_t position, const checksum256& node_hash) {
+            VOICE_TRACE_SCOPE("merkle.nodes");
+            auto it = by_position.find( merkle_node::build_position(tree.id, level, position) );
+            if (it == by_position.end()) {
+                if (node_hash != empty) {
+                    nodes.emplace( ram_payer, [&]( auto& n ) {
+                        n.id = nodes.available_primary_key();
+                        n.position = merkle_node::build_position(tree.id, level, position);
+                        n.hash = node_hash;
+                    });
+                }
+            } else if (node_hash == empty) {
+                by_position.erase(it);
+            } else {
+                by_position.modify( it, same_payer, [&]( auto& n ) {
+                    n.hash = node_hash;
+                });
+            }
+        };
+
+        // Adding a leaf past the capacity puts the current root under a new one
+        uint64_t leaf_count = std::max(tree.leaf_count, leaves.back().first + 1);
+        uint64_t depth = tree.depth;
+        checksum256 root = tree.root;
+        while ((1ull << depth) < leaf_count) {
+            set_node(depth, 0, root);
+            root = merkle::node_hash(root, empty);
+            depth++;
+        }
+
+        // Walks up one level at a time, siblings that both changed are hashed together
+        auto level_nodes = std::move(leaves);
+        for (uint64_t level = 0; level < depth; ++level) {
+            std::vector<std::pair<uint64_t, checksum256>> parents;
+            parents.reserve((level_nodes.size() + 1) / 2);
+            for (std::size_t i = 0; i < level_nodes.size(); ++i) {
+                const uint64_t position = level_nodes[i].first;
+                const checksum256 current = level_nodes[i].second;
+                set_node(level, position, current);
+
+                checksum256 sibling;
+                if ((position & 1) == 0 && i + 1 < level_nodes.size() && level_nodes[i + 1].first == position + 1) {
+                    sibling = level_nodes[++i].second;
+                    set_node(level, position + 1, sibling);
+                } else {
+                    sibling = get_node(level, position ^ 1);
+                }
+                parents.emplace_back(position >> 1, VOICE_TRACE_EXPR("merkle.hash",
+                        (position & 1) ? merkle::node_hash(sibling, current) : merkle::node_hash(current, sibling)));
+            }
+            level_nodes = std::move(parents);
+        }
+
+        trees.modify( tree, same_payer, [&]( auto& t ) {
+            t.leaf_count = leaf_count;
+            t.depth = depth;
+            t.root = level_nodes.front().second;
+        });
     }
 
     uint64_t voice::get_current_time() {
@@ -124,6 +124,207 @@ void test_decay_case_01() {
     assert(result.newPeriod == 1643328538);
 }
 
+void test_decay_policy_exponential_matches_default() {
+    const hypha::DecayConfig config{
+            .decayPeriod    = ONE_DAY_SECONDS,
+            .evaluationTime = ONE_DAY_SECONDS * 7 + 10,
+            .decayPerPeriod = 0.02
+    };
+
+    auto result = hypha::decay<hypha::ExponentialDecay>(123456789, 0, config);
+    auto expected = hypha::decay(123456789, 0, config);
+
+    assert(result.newBalance == expected.newBalance);
+    assert(result.needsUpdate == expected.needsUpdate);
+    assert(result.newPeriod == expected.newPeriod);
+}
+
+void test_decay_policy_linear() {
+    auto result = hypha::decay<hypha::LinearDecay>(100, 0, hypha::DecayConfig{
+            .decayPeriod    = 10,
+            .evaluationTime = 35,
+            .decayPerPeriod = 0.1
+    });
+
+    assert(result.newBalance == 70);
+    assert(result.needsUpdate == true);
+    assert(result.newPeriod == 30);
+
+    auto drained = hypha::decay<hypha::LinearDecay>(100, 0, hypha::DecayConfig{
+            .decayPeriod    = 10,
+            .evaluationTime = 30,
+            .decayPerPeriod = 0.5
+    });
+
+    assert(drained.newBalance == 0);
+    assert(drained.newPeriod == 30);
+}
+
+void test_decay_policy_none() {
+    auto result = hypha::decay<hypha::NoDecay>(100, 0, hypha::DecayConfig{
+            .decayPeriod    = 10,
+            .evaluationTime = 1000,
+            .decayPerPeriod = 0.5
+    });
+
+    assert(result.newBalance == 100);
+    assert(result.needsUpdate == false);
+    assert(result.newPeriod == 0);
+}
+
+void test_decay_aligned_to_epoch() {
+    // case_01 with periods ending on multiples of a day since the epoch
+    const hypha::DecayConfig config{
+            .decayPeriod    = ONE_DAY_SECONDS,
+            .evaluationTime = 1643328539,
+            .decayPerPeriod = 0.50,
+            .alignToEpoch   = true
+    };
+
+    auto result = hypha::decay(25000, 1643242138, config);
+    assert(result.needsUpdate == true);
+    assert(result.newBalance == 12500);
+    assert(result.newPeriod == 1643328000);
+
+    // Anything last decayed in the same epoch ends on the same boundary
+    auto same_epoch = hypha::decay(25000, 1643241600, config);
+    assert(same_epoch.newBalance == 12500);
+    assert(same_epoch.newPeriod == result.newPeriod);
+
+    // Not a whole period since the last decay, but a boundary was crossed
+    auto crossed = hypha::decay(100, 1643327999, config);
+    assert(crossed.newBalance == 50);
+    assert(crossed.newPeriod == 1643328000);
+
+    auto settled = hypha::decay(100, 1643328000, config);
+    assert(settled.needsUpdate == false);
+}
+
+void test_decay_factors_match_decay() {
+    const hypha::DecayConfig config{
+            .decayPeriod    = 10,
+            .evaluationTime = 1000,
+            .decayPerPeriod = 0.02,
+            .alignToEpoch   = true
+    };
+
+    hypha::DecayFactors<hypha::ExponentialDecay> factors(config);
+    for (uint64_t last = 0; last <= 1000; last += 7) {
+        auto cached = factors.decay(123456 + last, last);
+        auto expected = hypha::decay<hypha::ExponentialDecay>(123456 + last, last, config);
+        assert(cached.newBalance == expected.newBalance);
+        assert(cached.needsUpdate == expected.needsUpdate);
+        assert(cached.newPeriod == expected.newPeriod);
+    }
+}
+
+void test_project_decay() {
+    const hypha::DecayConfig config{
+            .decayPeriod    = 10,
+            .evaluationTime = 25,
+            .decayPerPeriod = 0.1
+    };
+
+    auto points = hypha::project_decay<hypha::ExponentialDecay>(100, 3, config, 3);
+    assert(points.size() == 3);
+    assert(points[0].time == 33 && points[0].balance == 73);
+    assert(points[1].time == 43 && points[1].balance == 66);
+    assert(points[2].time == 53 && points[2].balance == 59);
+
+    hypha::DecayConfig aligned = config;
+    aligned.alignToEpoch = true;
+    points = hypha::project_decay<hypha::ExponentialDecay>(100, 3, aligned, 2);
+    assert(points.size() == 2);
+    assert(points[0].time == 30 && points[0].balance == 73);
+    assert(points[1].time == 40 && points[1].balance == 66);
+
+    points = hypha::project_decay<hypha::NoDecay>(100, 3, config, 2);
+    assert(points.size() == 2);
+    assert(points[0].balance == 100 && points[1].balance == 100);
+}
+
+template<typename Policy>
+void check_decay_below(const hypha::DecayConfig& config, const uint64_t last) {
+    for (uint64_t balance = 1; balance <= 5000; balance = balance * 3 / 2 + 1) {
+        for (uint64_t threshold = 1; threshold <= balance; threshold = threshold * 2 + 1) {
+            const auto crossing = hypha::decay_below<Policy>(balance, last, config, threshold);
+            assert(crossing.crosses);
+
+            hypha::DecayConfig at = config;
+            at.evaluationTime = crossing.time;
+            assert(hypha::decay<Policy>(balance, last, at).newBalance < threshold);
+            at.evaluationTime = crossing.time - 1;
+            assert(hypha::decay<Policy>(balance, last, at).newBalance >= threshold);
+        }
+    }
+}
+
+void test_decay_below() {
+    const hypha::DecayConfig config{
+            .decayPeriod    = ONE_DAY_SECONDS,
+            .evaluationTime = 0,
+            .decayPerPeriod = 0.013
+    };
+    check_decay_below<hypha::ExponentialDecay>(config, 1000);
+    check_decay_below<hypha::LinearDecay>(config, 1000);
+
+    hypha::DecayConfig aligned = config;
+    aligned.alignToEpoch = true;
+    check_decay_below<hypha::ExponentialDecay>(aligned, ONE_DAY_SECONDS * 3 + 1000);
+    check_decay_below<hypha::LinearDecay>(aligned, ONE_DAY_SECONDS * 3 + 1000);
+
+    auto below = hypha::decay_below<hypha::ExponentialDecay>(10, 1000, config, 11);
+    assert(below.crosses && below.time == 1000);
+    assert(!hypha::decay_below<hypha::NoDecay>(100, 1000, config, 50).crosses);
+    assert(!hypha::decay_below<hypha::ExponentialDecay>(100, 1000, config, 0).crosses);
+}
+
+void test_linear_settlements_compose() {
+    hypha::DecayConfig config{
+            .decayPeriod    = 10,
+            .evaluationTime = 0,
+            .decayPerPeriod = 0.1
+    };
+    const hypha::DecayAnchor anchor{ 1000, 0 };
+
+    // Settled every period from the same anchor, or once, both lose 10% of 1000 a period
+    uint64_t balance = 1000;
+    uint64_t last = 0;
+    for (uint64_t t = 13; t <= 53; t += 10) {
+        config.evaluationTime = t;
+        auto result = hypha::decay<hypha::LinearDecay>(balance, last, config, anchor);
+        assert(result.needsUpdate);
+        balance = result.newBalance;
+        last = result.newPeriod;
+    }
+    config.evaluationTime = 55;
+    assert(balance == 500 && last == 50);
+    assert(hypha::decay<hypha::LinearDecay>(1000, 0, config, anchor).newBalance == 500);
+    assert(!hypha::decay<hypha::LinearDecay>(balance, last, config, anchor).needsUpdate);
+
+    // Projections and crossings start from the anchor too
+    config.evaluationTime = 25;
+    auto points = hypha::project_decay<hypha::LinearDecay>(800, 20, config, 2, anchor);
+    assert(points[0].time == 30 && points[0].balance == 700);
+    assert(points[1].time == 40 && points[1].balance == 600);
+    auto crossing = hypha::decay_below<hypha::LinearDecay>(800, 20, config, 550, anchor);
+    assert(crossing.crosses && crossing.time == 50);
+
+    // Exponential decay ignores the anchor
+    assert(hypha::decay<hypha::ExponentialDecay>(810, 20, config, anchor).newBalance == 810);
+}
+
+void test_anchor_never_raises_a_balance() {
+    // 500 settled from the anchor at 10% a period, then read at a lower rate
+    const hypha::DecayConfig config{
+            .decayPeriod    = 10,
+            .evaluationTime = 65,
+            .decayPerPeriod = 0.05
+    };
+    auto result = hypha::decay<hypha::LinearDecay>(500, 50, config, hypha::DecayAnchor{ 1000, 0 });
+    assert(result.needsUpdate && result.newPeriod == 60 && result.newBalance == 500);
+}
+
 int main(int argc, char** argv) {
     test_decay_one_period();
     test_decay_one_period_not_exact();
@@ -134,5 +335,14 @@ int main(int argc, char** argv) {
     test_decay_period_evaluated_in_the_past();
     test_decay_multiple_decays();
     test_decay_case_01();
+    test_decay_policy_exponential_matches_default();
+    test_decay_policy_linear();
+    test_decay_policy_none();
+    test_decay_aligned_to_epoch();
+    test_decay_factors_match_decay();
+    test_project_decay();
+    test_decay_below();
+    test_linear_settlements_compose();
+    test_anchor_never_raises_a_balance();
     return 0;
 }
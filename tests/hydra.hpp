@@ -1,6 +1,7 @@
 #pragma once
 #include <eosio/eosio.hpp>
 #include <eosio/print.hpp>
+#include <eosio/singleton.hpp>
 
 // multi_index does not expose indices_type, value_type and tableName
 // need to pass all three tablename, row type, and table definition to template
@@ -32,10 +33,102 @@ struct hydraload_payload {
   eosio::name scope;
   std::vector<char> row_data;
 };
+
+// Chunked fixtures, for seeding states too large for a single hydraload.
+// A chunk is the payload of one hydrachunk action and groups rows by table
+// and scope, so each table is opened once per segment and rows are unpacked
+// straight from the action data:
+//
+//   chunk   := hydra_chunk_header segment*
+//   segment := hydra_segment_header (uint32 size, row)*
+//
+// Rows carry their size, like rows stored on chain, so rows ending before a
+// binary_extension field read back without it.
+//
+// Chunks must be applied in sequence order. The next expected sequence is
+// kept in the hydrachunks singleton, so an interrupted load resumes by
+// resending everything from there; chunks already applied are skipped.
+constexpr uint32_t HYDRA_CHUNK_MAGIC = 0x32584648; // "HFX2"
+
+struct hydra_chunk_header {
+  uint32_t magic;
+  uint64_t sequence;
+  uint32_t segment_count;
+};
+
+struct hydra_segment_header {
+  eosio::name table_name;
+  eosio::name scope;
+  uint32_t row_count;
+};
+
+struct hydra_chunk_progress {
+  uint64_t next_sequence = 0;
+};
+
+using hydra_chunk_progress_table =
+    eosio::singleton<"hydrachunks"_n, hydra_chunk_progress>;
+
+template <typename RowType, typename MultiIndexType>
+void hydra_insert_rows(const eosio::name &_self, const eosio::name &scope,
+                       eosio::datastream<const char *> &ds,
+                       uint32_t row_count) {
+  MultiIndexType table(_self, scope.value);
+  for (uint32_t i = 0; i < row_count; ++i) {
+    uint32_t row_size;
+    ds >> row_size;
+    eosio::check(ds.remaining() >= row_size, "Truncated row in fixture chunk");
+    eosio::datastream<const char *> row_ds(ds.pos(), row_size);
+    RowType row;
+    row_ds >> row;
+    ds.skip(row_size);
+    table.emplace(_self, [&](auto &obj) { obj = row; });
+  }
+}
+
+// Returns false when the chunk was already applied by an earlier call
+template <typename InsertSegment>
+bool hydra_apply_chunk(const eosio::name &_self, const char *data,
+                       size_t size, InsertSegment &&insert_segment) {
+  eosio::datastream<const char *> ds(data, size);
+  hydra_chunk_header header;
+  ds >> header;
+  eosio::check(header.magic == HYDRA_CHUNK_MAGIC, "Invalid fixture chunk");
+
+  hydra_chunk_progress_table progress(_self, _self.value);
+  auto state = progress.get_or_default();
+  if (header.sequence < state.next_sequence) {
+    return false;
+  }
+  eosio::check(header.sequence == state.next_sequence,
+               "Fixture chunk out of order");
+
+  for (uint32_t i = 0; i < header.segment_count; ++i) {
+    hydra_segment_header segment;
+    ds >> segment;
+    insert_segment(segment, ds);
+  }
+  eosio::check(ds.remaining() == 0, "Trailing data in fixture chunk");
+
+  state.next_sequence = header.sequence + 1;
+  progress.set(state, _self);
+  return true;
+}
+
+#define HYDRA_POPULATE_SEGMENT(r, dummy, field)                                \
+  case HYDRA_TONAME(BOOST_PP_SEQ_ELEM(0, field)).value: {                      \
+    hydra_insert_rows<BOOST_PP_SEQ_ELEM(1, field),                             \
+                      BOOST_PP_SEQ_ELEM(2, field)>(get_self(), segment.scope,  \
+                                                   ds, segment.row_count);     \
+    break;                                                                     \
+  }
+
 // define this for production use
 #ifdef HYDRA_SKIP_HELPERS
 #define HYDRA_FIXTURE_ACTION(TABLES)
 #define HYDRA_APPLY_FIXTURE_ACTION(CONTRACTNAME)
+#define HYDRA_CHUNKED_FIXTURE_ACTION(TABLES)
+#define HYDRA_APPLY_CHUNKED_FIXTURE_ACTION(CONTRACTNAME)
 #else
 #define HYDRA_FIXTURE_ACTION(TABLES)                                           \
   ACTION hydraload(const std::vector<hydraload_payload> payload) {             \
@@ -53,4 +146,24 @@ struct hydraload_payload {
   if (code == receiver && action == eosio::name("hydraload").value)            \
     eosio::execute_action(eosio::name(receiver), eosio::name(code),            \
                           &CONTRACTNAME::hydraload);
+
+#define HYDRA_CHUNKED_FIXTURE_ACTION(TABLES)                                   \
+  ACTION hydrachunk(const std::vector<char> &chunk) {                          \
+    require_auth(eosio::name("eosio"));                                        \
+    hydra_apply_chunk(                                                         \
+        get_self(), chunk.data(), chunk.size(),                                \
+        [&](const hydra_segment_header &segment,                               \
+            eosio::datastream<const char *> &ds) {                             \
+          switch (segment.table_name.value) {                                  \
+            BOOST_PP_SEQ_FOR_EACH(HYDRA_POPULATE_SEGMENT, DUMMY_MACRO, TABLES) \
+          default:                                                             \
+            eosio::check(false, "Unknown table to load fixture");              \
+          }                                                                    \
+        });                                                                    \
+  }
+
+#define HYDRA_APPLY_CHUNKED_FIXTURE_ACTION(CONTRACTNAME)                       \
+  if (code == receiver && action == eosio::name("hydrachunk").value)           \
+    eosio::execute_action(eosio::name(receiver), eosio::name(code),            \
+                          &CONTRACTNAME::hydrachunk);
 #endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <eosio/check.hpp>
+#include <eosio/symbol.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace eosio {
+
+    struct asset {
+        int64_t amount = 0;
+        eosio::symbol symbol;
+
+        static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+        asset() {}
+
+        asset(int64_t a, class symbol s) : amount(a), symbol{s} {
+            check(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+            check(symbol.is_valid(), "invalid symbol name");
+        }
+
+        bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+
+        bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+        asset operator-() const {
+            asset r = *this;
+            r.amount = -r.amount;
+            return r;
+        }
+
+        asset& operator-=(const asset& a) {
+            check(a.symbol == symbol, "attempt to subtract asset with different symbol");
+            amount -= a.amount;
+            check(-max_amount <= amount, "subtraction underflow");
+            check(amount <= max_amount, "subtraction overflow");
+            return *this;
+        }
+
+        asset& operator+=(const asset& a) {
+            check(a.symbol == symbol, "attempt to add asset with different symbol");
+            amount += a.amount;
+            check(-max_amount <= amount, "addition underflow");
+            check(amount <= max_amount, "addition overflow");
+            return *this;
+        }
+
+        friend asset operator+(const asset& a, const asset& b) {
+            asset result = a;
+            result += b;
+            return result;
+        }
+
+        friend asset operator-(const asset& a, const asset& b) {
+            asset result = a;
+            result -= b;
+            return result;
+        }
+
+        asset& operator*=(int64_t a) {
+            __int128 tmp = (__int128)amount * (__int128)a;
+            check(tmp <= max_amount, "multiplication overflow");
+            check(tmp >= -max_amount, "multiplication underflow");
+            amount = (int64_t)tmp;
+            return *this;
+        }
+
+        friend asset operator*(const asset& a, int64_t b) {
+            asset result = a;
+            result *= b;
+            return result;
+        }
+
+        friend asset operator*(int64_t b, const asset& a) {
+            asset result = a;
+            result *= b;
+            return result;
+        }
+
+        std::string to_string() const {
+            auto p = symbol.precision();
+            bool negative = amount < 0;
+            uint64_t abs = negative ? -amount : amount;
+
+            uint64_t scale = 1;
+            for (uint8_t i = 0; i < p; ++i) {
+                scale *= 10;
+            }
+
+            std::string result = (negative ? "-" : "") + std::to_string(abs / scale);
+            if (p > 0) {
+                std::string fraction = std::to_string(abs % scale);
+                result += "." + std::string(p - fraction.size(), '0') + fraction;
+            }
+            return result + " " + symbol.code().to_string();
+        }
+
+        friend bool operator==(const asset& a, const asset& b) {
+            check(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+            return a.amount == b.amount;
+        }
+
+        friend bool operator!=(const asset& a, const asset& b) { return !(a == b); }
+    };
+}
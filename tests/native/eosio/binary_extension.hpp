@@ -0,0 +1,70 @@
+#pragma once
+#include <eosio/check.hpp>
+#include <eosio/datastream.hpp>
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+    /**
+     * Field appended to an existing table or action. Rows written before the
+     * field existed end before it and read back without a value.
+     */
+    template<typename T>
+    class binary_extension {
+    public:
+        binary_extension() = default;
+        binary_extension(const T& value) : _value(value) {}
+
+        bool has_value() const { return _value.has_value(); }
+
+        const T& value() const {
+            check(has_value(), "cannot get value of empty binary_extension");
+            return *_value;
+        }
+
+        // Same overloads as the CDT: only a non-const extension takes a default
+        template<typename U>
+        auto value_or(U&& def) -> std::enable_if_t<std::is_convertible<U, T>::value, T&> {
+            return has_value() ? *_value : def;
+        }
+
+        const T& value_or() const {
+            static const T def{};
+            return has_value() ? *_value : def;
+        }
+
+        template<typename... Args>
+        binary_extension& emplace(Args&&... args) {
+            _value.emplace(std::forward<Args>(args)...);
+            return *this;
+        }
+
+        void reset() { _value.reset(); }
+
+    private:
+        std::optional<T> _value;
+    };
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const binary_extension<T>& v) {
+        if (v.has_value()) {
+            ds << v.value();
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, binary_extension<T>& v) {
+        if (ds.remaining() > 0) {
+            T value;
+            ds >> value;
+            v.emplace(value);
+        } else {
+            v.reset();
+        }
+        return ds;
+    }
+}
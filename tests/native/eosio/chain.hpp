@@ -0,0 +1,93 @@
+#pragma once
+#include <eosio/name.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * In-memory stand-in for the pieces of chain state the contract reads
+ * through intrinsics: head block time, the authorizations of the current
+ * action, existing accounts and notified recipients. Also counts the
+ * table rows billed to each account.
+ *
+ * Tests drive it through the `eosio::mock` functions; contract code only
+ * sees the regular `eosio::` API on top of it.
+ */
+namespace eosio::mock {
+
+    struct chain_state {
+        uint64_t                 now_us = 0;
+        std::vector<name>        auths;
+        std::set<name>           accounts;
+        std::vector<name>        recipients;
+        std::map<name, int64_t>  billed_rows;
+        std::vector<std::function<void()>> table_resets;
+    };
+
+    inline chain_state& chain() {
+        static chain_state state;
+        return state;
+    }
+
+    // Drops every table row and all chain state
+    inline void reset() {
+        auto& c = chain();
+        for (auto& reset_table : c.table_resets) {
+            reset_table();
+        }
+        c.now_us = 0;
+        c.auths.clear();
+        c.accounts.clear();
+        c.recipients.clear();
+        c.billed_rows.clear();
+    }
+
+    inline void set_time(uint64_t sec) { chain().now_us = sec * 1000000ull; }
+
+    inline void advance_time(uint64_t sec) { chain().now_us += sec * 1000000ull; }
+
+    // Authorizations granted to the next actions, replaces the previous set
+    inline void set_auth(std::vector<name> auths) { chain().auths = std::move(auths); }
+
+    inline void create_account(const name& account) { chain().accounts.insert(account); }
+
+    inline void create_accounts(const std::vector<name>& accounts) {
+        chain().accounts.insert(accounts.begin(), accounts.end());
+    }
+
+    // Number of table rows the account currently pays RAM for
+    inline int64_t rows_billed_to(const name& account) {
+        auto it = chain().billed_rows.find(account);
+        return it != chain().billed_rows.end() ? it->second : 0;
+    }
+}
+
+namespace eosio {
+
+    inline bool has_auth(const name& n) {
+        const auto& auths = mock::chain().auths;
+        return std::find(auths.begin(), auths.end(), n) != auths.end();
+    }
+
+    inline void require_auth(const name& n) {
+        check(has_auth(n), "missing authority of " + n.to_string());
+    }
+
+    inline bool is_account(const name& n) {
+        return mock::chain().accounts.count(n) > 0;
+    }
+
+    inline void require_recipient(const name& notify_account) {
+        mock::chain().recipients.push_back(notify_account);
+    }
+
+    template<typename... Accounts>
+    void require_recipient(const name& notify_account, Accounts... remaining) {
+        require_recipient(notify_account);
+        require_recipient(remaining...);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+namespace eosio {
+
+    /**
+     * Thrown by `check` when an assertion fails. On chain this aborts the
+     * transaction, natively it unwinds to the test that invoked the action.
+     */
+    struct check_failure : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    inline void check(bool pred, const char* msg) {
+        if (!pred) {
+            throw check_failure(msg);
+        }
+    }
+
+    inline void check(bool pred, const std::string& msg) {
+        if (!pred) {
+            throw check_failure(msg);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <eosio/datastream.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace eosio {
+
+    // Only the 32 byte form is needed by the contracts, stored as bytes
+    class checksum256 {
+    public:
+        checksum256() : _bytes{} {}
+
+        explicit checksum256(const std::array<uint8_t, 32>& bytes) : _bytes(bytes) {}
+
+        std::array<uint8_t, 32> extract_as_byte_array() const { return _bytes; }
+
+        const uint8_t* data() const { return _bytes.data(); }
+
+        std::size_t size() const { return _bytes.size(); }
+
+        friend bool operator==(const checksum256& a, const checksum256& b) { return a._bytes == b._bytes; }
+        friend bool operator!=(const checksum256& a, const checksum256& b) { return a._bytes != b._bytes; }
+        friend bool operator<(const checksum256& a, const checksum256& b) { return a._bytes < b._bytes; }
+
+    private:
+        std::array<uint8_t, 32> _bytes;
+    };
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const checksum256& v) {
+        ds.write(v.data(), v.size());
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, checksum256& v) {
+        std::array<uint8_t, 32> bytes;
+        ds.read(bytes.data(), bytes.size());
+        v = checksum256(bytes);
+        return ds;
+    }
+
+    namespace mock {
+
+        // Plain FIPS 180-4 SHA-256, standing in for the sha256 intrinsic
+        class sha256_state {
+        public:
+            void update(const uint8_t* data, std::size_t len) {
+                while (len > 0) {
+                    std::size_t n = std::min<std::size_t>(len, 64 - _block_len);
+                    std::memcpy(_block + _block_len, data, n);
+                    _block_len += n;
+                    data += n;
+                    len -= n;
+                    if (_block_len == 64) {
+                        transform();
+                        _bit_len += 512;
+                        _block_len = 0;
+                    }
+                }
+            }
+
+            std::array<uint8_t, 32> finish() {
+                uint64_t bit_len = _bit_len + uint64_t(_block_len) * 8;
+                uint8_t pad = 0x80;
+                update(&pad, 1);
+                pad = 0;
+                while (_block_len != 56) {
+                    update(&pad, 1);
+                }
+                for (int i = 7; i >= 0; --i) {
+                    uint8_t b = uint8_t(bit_len >> (i * 8));
+                    update(&b, 1);
+                }
+
+                std::array<uint8_t, 32> out;
+                for (int i = 0; i < 8; ++i) {
+                    for (int j = 0; j < 4; ++j) {
+                        out[i * 4 + j] = uint8_t(_h[i] >> (24 - j * 8));
+                    }
+                }
+                return out;
+            }
+
+        private:
+            static uint32_t rotr(uint32_t x, uint32_t n) { return (x >> n) | (x << (32 - n)); }
+
+            void transform() {
+                static constexpr uint32_t k[64] = {
+                    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+                };
+
+                uint32_t w[64];
+                for (int i = 0; i < 16; ++i) {
+                    w[i] = (uint32_t(_block[i * 4]) << 24) | (uint32_t(_block[i * 4 + 1]) << 16) |
+                           (uint32_t(_block[i * 4 + 2]) << 8) | uint32_t(_block[i * 4 + 3]);
+                }
+                for (int i = 16; i < 64; ++i) {
+                    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                uint32_t a = _h[0], b = _h[1], c = _h[2], d = _h[3], e = _h[4], f = _h[5], g = _h[6], h = _h[7];
+                for (int i = 0; i < 64; ++i) {
+                    uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                    uint32_t ch = (e & f) ^ (~e & g);
+                    uint32_t t1 = h + s1 + ch + k[i] + w[i];
+                    uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                    uint32_t t2 = s0 + maj;
+                    h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+                }
+
+                _h[0] += a; _h[1] += b; _h[2] += c; _h[3] += d;
+                _h[4] += e; _h[5] += f; _h[6] += g; _h[7] += h;
+            }
+
+            uint32_t _h[8] = {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+            };
+            uint8_t _block[64];
+            uint32_t _block_len = 0;
+            uint64_t _bit_len = 0;
+        };
+    }
+
+    inline checksum256 sha256(const char* data, uint32_t length) {
+        mock::sha256_state state;
+        state.update(reinterpret_cast<const uint8_t*>(data), length);
+        return checksum256(state.finish());
+    }
+}
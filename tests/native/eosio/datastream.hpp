@@ -0,0 +1,267 @@
+#pragma once
+#include <eosio/asset.hpp>
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+#include <eosio/symbol.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace eosio {
+
+    template<typename T>
+    class datastream {
+    public:
+        datastream(T start, std::size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+        bool read(void* d, std::size_t s) {
+            check(std::size_t(_end - _pos) >= s, "datastream attempted to read past the end");
+            std::memcpy(d, _pos, s);
+            _pos += s;
+            return true;
+        }
+
+        bool write(const void* d, std::size_t s) {
+            check(std::size_t(_end - _pos) >= s, "datastream attempted to write past the end");
+            std::memcpy(_pos, d, s);
+            _pos += s;
+            return true;
+        }
+
+        bool skip(std::size_t s) {
+            check(std::size_t(_end - _pos) >= s, "datastream attempted to skip past the end");
+            _pos += s;
+            return true;
+        }
+
+        T pos() const { return _pos; }
+        std::size_t tellp() const { return std::size_t(_pos - _start); }
+        std::size_t remaining() const { return std::size_t(_end - _pos); }
+
+    private:
+        T _start;
+        T _pos;
+        T _end;
+    };
+
+    // Size-counting stream, as in the CDT
+    template<>
+    class datastream<std::size_t> {
+    public:
+        datastream(std::size_t init_size = 0) : _size(init_size) {}
+
+        bool write(const void*, std::size_t s) { _size += s; return true; }
+        bool skip(std::size_t s) { _size += s; return true; }
+
+        std::size_t tellp() const { return _size; }
+        std::size_t remaining() const { return 0; }
+
+    private:
+        std::size_t _size;
+    };
+
+    namespace reflect {
+
+        // Converts to any field type, used to count the fields of an aggregate
+        struct any_field {
+            template<typename U>
+            operator U() const;
+        };
+
+        template<typename T, typename... Fields>
+        constexpr auto brace_initializable(int) -> decltype(T{std::declval<Fields>()...}, true) { return true; }
+
+        template<typename T, typename... Fields>
+        constexpr bool brace_initializable(...) { return false; }
+
+        template<typename T, typename... Fields>
+        constexpr std::size_t fields() {
+            if constexpr (brace_initializable<T, Fields..., any_field>(0)) {
+                return fields<T, Fields..., any_field>();
+            } else {
+                return sizeof...(Fields);
+            }
+        }
+
+        /**
+         * Field-by-field view of a table row, standing in for the reflection
+         * the CDT uses to serialize aggregates.
+         */
+        template<typename T>
+        auto tie(T& t) {
+            constexpr std::size_t n = fields<std::remove_const_t<T>>();
+            static_assert(n > 0 && n <= 10, "only aggregates with 1 to 10 fields can be serialized");
+            if constexpr (n == 1) { auto& [a] = t; return std::tie(a); }
+            else if constexpr (n == 2) { auto& [a, b] = t; return std::tie(a, b); }
+            else if constexpr (n == 3) { auto& [a, b, c] = t; return std::tie(a, b, c); }
+            else if constexpr (n == 4) { auto& [a, b, c, d] = t; return std::tie(a, b, c, d); }
+            else if constexpr (n == 5) { auto& [a, b, c, d, e] = t; return std::tie(a, b, c, d, e); }
+            else if constexpr (n == 6) { auto& [a, b, c, d, e, f] = t; return std::tie(a, b, c, d, e, f); }
+            else if constexpr (n == 7) { auto& [a, b, c, d, e, f, g] = t; return std::tie(a, b, c, d, e, f, g); }
+            else if constexpr (n == 8) { auto& [a, b, c, d, e, f, g, h] = t; return std::tie(a, b, c, d, e, f, g, h); }
+            else if constexpr (n == 9) { auto& [a, b, c, d, e, f, g, h, i] = t; return std::tie(a, b, c, d, e, f, g, h, i); }
+            else { auto& [a, b, c, d, e, f, g, h, i, j] = t; return std::tie(a, b, c, d, e, f, g, h, i, j); }
+        }
+    }
+
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v) {
+        ds.write(&v, sizeof(T));
+        return ds;
+    }
+
+    template<typename Stream, typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, T& v) {
+        ds.read(&v, sizeof(T));
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const unsigned __int128& v) {
+        ds.write(&v, sizeof(v));
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, unsigned __int128& v) {
+        ds.read(&v, sizeof(v));
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const name& v) { return ds << v.value; }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, name& v) { return ds >> v.value; }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const symbol_code& v) { return ds << v.raw(); }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, symbol_code& v) {
+        uint64_t raw;
+        ds >> raw;
+        v = symbol_code(raw);
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const symbol& v) { return ds << v.raw(); }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, symbol& v) {
+        uint64_t raw;
+        ds >> raw;
+        v = symbol(raw);
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const asset& v) { return ds << v.amount << v.symbol; }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, asset& v) { return ds >> v.amount >> v.symbol; }
+
+    template<typename Stream>
+    void write_varuint32(datastream<Stream>& ds, uint32_t v) {
+        do {
+            uint8_t b = uint8_t(v & 0x7f);
+            v >>= 7;
+            b |= ((v > 0) << 7);
+            ds.write(&b, 1);
+        } while (v);
+    }
+
+    template<typename Stream>
+    uint32_t read_varuint32(datastream<Stream>& ds) {
+        uint64_t v = 0;
+        uint8_t b = 0;
+        uint8_t by = 0;
+        do {
+            ds.read(&b, 1);
+            v |= uint64_t(b & 0x7f) << by;
+            by += 7;
+        } while ((b & 0x80) && by < 32);
+        return uint32_t(v);
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::string& v) {
+        write_varuint32(ds, uint32_t(v.size()));
+        ds.write(v.data(), v.size());
+        return ds;
+    }
+
+    template<typename Stream>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::string& v) {
+        uint32_t size = read_varuint32(ds);
+        v.resize(size);
+        ds.read(v.data(), size);
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const std::vector<T>& v) {
+        write_varuint32(ds, uint32_t(v.size()));
+        for (const auto& i : v) {
+            ds << i;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, std::vector<T>& v) {
+        uint32_t size = read_varuint32(ds);
+        v.resize(size);
+        for (auto& i : v) {
+            ds >> i;
+        }
+        return ds;
+    }
+
+    template<typename Stream, typename T,
+             std::enable_if_t<std::is_class_v<T> && std::is_aggregate_v<T>, int> = 0>
+    datastream<Stream>& operator<<(datastream<Stream>& ds, const T& v) {
+        std::apply([&](const auto&... fields) { (ds << ... << fields); }, reflect::tie(v));
+        return ds;
+    }
+
+    template<typename Stream, typename T,
+             std::enable_if_t<std::is_class_v<T> && std::is_aggregate_v<T>, int> = 0>
+    datastream<Stream>& operator>>(datastream<Stream>& ds, T& v) {
+        std::apply([&](auto&... fields) { (ds >> ... >> fields); }, reflect::tie(v));
+        return ds;
+    }
+
+    template<typename T>
+    std::size_t pack_size(const T& value) {
+        datastream<std::size_t> ps;
+        ps << value;
+        return ps.tellp();
+    }
+
+    template<typename T>
+    std::vector<char> pack(const T& value) {
+        std::vector<char> result(pack_size(value));
+        datastream<char*> ds(result.data(), result.size());
+        ds << value;
+        return result;
+    }
+
+    template<typename T>
+    T unpack(const char* buffer, std::size_t len) {
+        T result;
+        datastream<const char*> ds(buffer, len);
+        ds >> result;
+        return result;
+    }
+
+    template<typename T>
+    T unpack(const std::vector<char>& bytes) {
+        return unpack<T>(bytes.data(), bytes.size());
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+/**
+ * Host build replacement of the CDT `<eosio/eosio.hpp>` umbrella header.
+ *
+ * Only the include directory of tests/native shadows the CDT headers, the
+ * contract sources are compiled unchanged against it.
+ */
+#include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
+#include <eosio/chain.hpp>
+#include <eosio/check.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/print.hpp>
+#include <eosio/symbol.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned __int128 uint128_t;
+typedef __int128          int128_t;
+
+#define ACTION [[eosio::action]] void
+#define TABLE struct [[eosio::table]]
+#define CONTRACT class [[eosio::contract]]
+
+namespace eosio {
+
+    static constexpr name same_payer{};
+
+    class contract {
+    public:
+        contract(name self, name first_receiver, datastream<const char*> ds)
+            : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+        name get_self() const { return _self; }
+
+        name get_first_receiver() const { return _first_receiver; }
+
+        name get_code() const { return _first_receiver; }
+
+        datastream<const char*>& get_datastream() { return _ds; }
+
+    protected:
+        name _self;
+        name _first_receiver;
+        datastream<const char*> _ds = datastream<const char*>(nullptr, 0);
+    };
+
+    // Inline actions are not dispatched natively, the wrapper only has to exist
+    template<name::raw Name, auto Action>
+    struct action_wrapper {
+        static constexpr name action_name = name(Name);
+    };
+}
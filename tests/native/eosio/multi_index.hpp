@@ -0,0 +1,354 @@
+#pragma once
+#include <eosio/chain.hpp>
+#include <eosio/check.hpp>
+#include <eosio/name.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+
+namespace eosio {
+
+    template<class Class, class Type, Type (Class::*PtrToMemberFunction)() const>
+    struct const_mem_fun {
+        using result_type = Type;
+
+        Type operator()(const Class& obj) const { return (obj.*PtrToMemberFunction)(); }
+    };
+
+    template<name::raw IndexName, typename Extractor>
+    struct indexed_by {
+        static constexpr name::raw index_name = IndexName;
+        using secondary_extractor_type = Extractor;
+        using secondary_key_type = typename Extractor::result_type;
+    };
+
+    namespace mock {
+
+        /**
+         * Rows of one (code, scope) pair. Secondary indices are kept as ordered
+         * (secondary key, primary key) sets, which matches the iteration order
+         * of the chain's secondary index tables.
+         */
+        template<typename T, typename... Indices>
+        struct table_rows {
+            std::map<uint64_t, T> rows;
+            std::map<uint64_t, name> payers;
+            std::tuple<std::set<std::pair<typename Indices::secondary_key_type, uint64_t>>...> secondaries;
+
+            template<std::size_t... I>
+            void index_row(const T& obj, std::index_sequence<I...>) {
+                (std::get<I>(secondaries).emplace(
+                    typename Indices::secondary_extractor_type{}(obj), obj.primary_key()), ...);
+            }
+
+            template<std::size_t... I>
+            void unindex_row(const T& obj, std::index_sequence<I...>) {
+                (std::get<I>(secondaries).erase(
+                    {typename Indices::secondary_extractor_type{}(obj), obj.primary_key()}), ...);
+            }
+
+            void index_row(const T& obj) { index_row(obj, std::index_sequence_for<Indices...>{}); }
+
+            void unindex_row(const T& obj) { unindex_row(obj, std::index_sequence_for<Indices...>{}); }
+        };
+
+        // Moves the RAM of a row to `payer`, which like on chain must authorize the action unless it is the contract
+        inline void bill_row(const name& code, const name& payer, const name& previous) {
+            check(payer == code || has_auth(payer),
+                  "unprivileged contract cannot increase RAM usage of another account that has not authorized the action: "
+                  + payer.to_string());
+            if (previous.value != 0) {
+                --chain().billed_rows[previous];
+            }
+            ++chain().billed_rows[payer];
+        }
+    }
+
+    /**
+     * Host side replacement of `eosio::multi_index` storing rows in memory.
+     * Keeps the subset of the CDT interface used by the contracts in this
+     * repository with the same assertion messages.
+     */
+    template<name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+        using rows_type = mock::table_rows<T, Indices...>;
+        using storage_type = std::map<std::pair<uint64_t, uint64_t>, rows_type>;
+
+        static storage_type& storage() {
+            static storage_type* s = [] {
+                static storage_type instance;
+                mock::chain().table_resets.push_back([] { instance.clear(); });
+                return &instance;
+            }();
+            return *s;
+        }
+
+        template<name::raw IndexName, std::size_t I = 0>
+        static constexpr std::size_t index_position() {
+            static_assert(I < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+            if constexpr (std::tuple_element_t<I, std::tuple<Indices...>>::index_name == IndexName) {
+                return I;
+            } else {
+                return index_position<IndexName, I + 1>();
+            }
+        }
+
+    public:
+        class const_iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            const_iterator() = default;
+
+            const T& operator*() const { return _it->second; }
+            const T* operator->() const { return &_it->second; }
+
+            const_iterator& operator++() { ++_it; return *this; }
+            const_iterator& operator--() { --_it; return *this; }
+            const_iterator operator++(int) { auto r = *this; ++_it; return r; }
+            const_iterator operator--(int) { auto r = *this; --_it; return r; }
+
+            friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+            friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+        private:
+            friend class multi_index;
+            using base_iterator = typename std::map<uint64_t, T>::const_iterator;
+
+            explicit const_iterator(base_iterator it) : _it(it) {}
+
+            base_iterator _it;
+        };
+
+        template<std::size_t I>
+        class index {
+            using index_type = std::tuple_element_t<I, std::tuple<Indices...>>;
+            using secondary_key_type = typename index_type::secondary_key_type;
+            using set_type = std::tuple_element_t<I, decltype(rows_type::secondaries)>;
+
+        public:
+            class const_iterator {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+                const_iterator() = default;
+
+                const T& operator*() const { return _rows->rows.find(_it->second)->second; }
+                const T* operator->() const { return &**this; }
+
+                const_iterator& operator++() { ++_it; return *this; }
+                const_iterator& operator--() { --_it; return *this; }
+                const_iterator operator++(int) { auto r = *this; ++_it; return r; }
+                const_iterator operator--(int) { auto r = *this; --_it; return r; }
+
+                friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+                friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+            private:
+                friend class index;
+                using base_iterator = typename set_type::const_iterator;
+
+                const_iterator(const rows_type* rows, base_iterator it) : _rows(rows), _it(it) {}
+
+                const rows_type* _rows = nullptr;
+                base_iterator _it;
+            };
+
+            explicit index(multi_index* mi) : _multidx(mi) {}
+
+            const_iterator begin() const { return {_multidx->_rows, set().begin()}; }
+            const_iterator end() const { return {_multidx->_rows, set().end()}; }
+            const_iterator cbegin() const { return begin(); }
+            const_iterator cend() const { return end(); }
+
+            const_iterator lower_bound(const secondary_key_type& key) const {
+                return {_multidx->_rows, set().lower_bound({key, 0})};
+            }
+
+            const_iterator upper_bound(const secondary_key_type& key) const {
+                return {_multidx->_rows, set().upper_bound({key, UINT64_MAX})};
+            }
+
+            const_iterator find(const secondary_key_type& key) const {
+                auto itr = lower_bound(key);
+                if (itr == end() || itr._it->first != key) {
+                    return end();
+                }
+                return itr;
+            }
+
+            const_iterator require_find(const secondary_key_type& key, const char* error_msg = "unable to find secondary key") const {
+                auto itr = find(key);
+                check(itr != end(), error_msg);
+                return itr;
+            }
+
+            const T& get(const secondary_key_type& key, const char* error_msg = "unable to find secondary key") const {
+                return *require_find(key, error_msg);
+            }
+
+            const_iterator iterator_to(const T& obj) const {
+                auto itr = set().find({typename index_type::secondary_extractor_type{}(obj), obj.primary_key()});
+                check(itr != set().end(), "object passed to iterator_to is not in multi_index");
+                return {_multidx->_rows, itr};
+            }
+
+            template<typename Lambda>
+            void modify(const_iterator itr, name payer, Lambda&& updater) {
+                check(itr != end(), "cannot pass end iterator to modify");
+                _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+            }
+
+            const_iterator erase(const_iterator itr) {
+                check(itr != end(), "cannot pass end iterator to erase");
+                // set iterators other than the erased one stay valid
+                auto next = itr;
+                ++next;
+                _multidx->erase(*itr);
+                return next;
+            }
+
+            name get_code() const { return _multidx->get_code(); }
+            uint64_t get_scope() const { return _multidx->get_scope(); }
+
+        private:
+            const set_type& set() const { return std::get<I>(_multidx->_rows->secondaries); }
+
+            multi_index* _multidx;
+        };
+
+        // Mock only: visits (code, scope, row) for every row of this table
+        template<typename Visitor>
+        static void for_each_row(Visitor&& visit) {
+            for (const auto& [key, table] : storage()) {
+                for (const auto& [pk, row] : table.rows) {
+                    visit(name(key.first), key.second, row);
+                }
+            }
+        }
+
+        multi_index(name code, uint64_t scope)
+            : _code(code), _scope(scope), _rows(&storage()[{code.value, scope}]) {}
+
+        // Needed because indices keep a pointer back to their table
+        multi_index(const multi_index&) = delete;
+        multi_index& operator=(const multi_index&) = delete;
+
+        name get_code() const { return _code; }
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator begin() const { return const_iterator(_rows->rows.cbegin()); }
+        const_iterator end() const { return const_iterator(_rows->rows.cend()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        auto rbegin() const { return std::make_reverse_iterator(end()); }
+        auto rend() const { return std::make_reverse_iterator(begin()); }
+
+        const_iterator lower_bound(uint64_t primary) const { return const_iterator(_rows->rows.lower_bound(primary)); }
+        const_iterator upper_bound(uint64_t primary) const { return const_iterator(_rows->rows.upper_bound(primary)); }
+
+        uint64_t available_primary_key() const {
+            return _rows->rows.empty() ? 0 : _rows->rows.rbegin()->first + 1;
+        }
+
+        template<name::raw IndexName>
+        auto get_index() {
+            return index<index_position<IndexName>()>(this);
+        }
+
+        template<name::raw IndexName>
+        auto get_index() const {
+            return index<index_position<IndexName>()>(const_cast<multi_index*>(this));
+        }
+
+        const_iterator iterator_to(const T& obj) const {
+            auto itr = _rows->rows.find(obj.primary_key());
+            check(itr != _rows->rows.end(), "object passed to iterator_to is not in multi_index");
+            return const_iterator(itr);
+        }
+
+        template<typename Lambda>
+        const_iterator emplace(name payer, Lambda&& constructor) {
+            check(payer.value != 0, "must specify a valid account to pay for new record");
+
+            T obj;
+            constructor(obj);
+            auto pk = obj.primary_key();
+            check(_rows->rows.count(pk) == 0, "could not insert object, most likely a uniqueness constraint was violated");
+            mock::bill_row(_code, payer, name());
+            auto itr = _rows->rows.emplace(pk, std::move(obj)).first;
+            _rows->payers[pk] = payer;
+            _rows->index_row(itr->second);
+            return const_iterator(itr);
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda&& updater) {
+            check(itr != end(), "cannot pass end iterator to modify");
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template<typename Lambda>
+        void modify(const T& obj, name payer, Lambda&& updater) {
+            auto itr = _rows->rows.find(obj.primary_key());
+            check(itr != _rows->rows.end(), "object passed to modify is not in multi_index");
+
+            auto& row = itr->second;
+            auto pk = row.primary_key();
+            auto& billed = _rows->payers[pk];
+            if (payer.value != 0 && payer != billed) {
+                mock::bill_row(_code, payer, billed);
+                billed = payer;
+            }
+            _rows->unindex_row(row);
+            updater(row);
+            check(pk == row.primary_key(), "updater cannot change primary key when modifying an object");
+            _rows->index_row(row);
+        }
+
+        const T& get(uint64_t primary, const char* error_msg = "unable to find key") const {
+            auto itr = find(primary);
+            check(itr != end(), error_msg);
+            return *itr;
+        }
+
+        const_iterator find(uint64_t primary) const { return const_iterator(_rows->rows.find(primary)); }
+
+        const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const {
+            auto itr = find(primary);
+            check(itr != end(), error_msg);
+            return itr;
+        }
+
+        const_iterator erase(const_iterator itr) {
+            check(itr != end(), "cannot pass end iterator to erase");
+            _rows->unindex_row(*itr);
+            auto billed = _rows->payers.find(itr->primary_key());
+            --mock::chain().billed_rows[billed->second];
+            _rows->payers.erase(billed);
+            return const_iterator(_rows->rows.erase(itr._it));
+        }
+
+        void erase(const T& obj) {
+            erase(iterator_to(obj));
+        }
+
+    private:
+        name       _code;
+        uint64_t   _scope;
+        rows_type* _rows;
+    };
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <eosio/name.hpp>
+
+#include <iostream>
+
+namespace eosio {
+
+    inline void print_item(const name& n) { std::cout << n.to_string(); }
+
+    template<typename T>
+    void print_item(const T& t) { std::cout << t; }
+
+    template<typename... Args>
+    void print(Args&&... args) {
+        (print_item(args), ...);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <eosio/chain.hpp>
+
+#include <cstdint>
+
+namespace eosio {
+
+    class microseconds {
+    public:
+        explicit microseconds(int64_t c = 0) : _count(c) {}
+
+        int64_t count() const { return _count; }
+
+        int64_t to_seconds() const { return _count / 1000000; }
+
+    private:
+        int64_t _count;
+    };
+
+    class time_point {
+    public:
+        explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+
+        const microseconds& time_since_epoch() const { return elapsed; }
+
+        uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+        microseconds elapsed;
+    };
+
+    inline time_point current_time_point() {
+        return time_point(microseconds(mock::chain().now_us));
+    }
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include <hydra.hpp>
+#include <tables/account.hpp>
+#include <tables/currency_stats.hpp>
+#include <tables/merkle.hpp>
+#include <tables/reconcile.hpp>
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Reading and writing of chunked fixture files. A file is a sequence of
+ * chunks, each prefixed by its byte length as uint32; every chunk is the
+ * exact payload of one `hydrachunk` action (see tests/hydra.hpp).
+ */
+namespace hypha::fixture {
+
+    class chunk_writer {
+    public:
+        chunk_writer(std::ostream& out, uint32_t rows_per_chunk)
+            : _out(out), _rows_per_chunk(rows_per_chunk) {}
+
+        ~chunk_writer() { flush(); }
+
+        template<typename RowType>
+        void add(const eosio::name& table_name, const eosio::name& scope, const RowType& row) {
+            add_packed(table_name, scope, eosio::pack(row));
+        }
+
+        // Adds a row already serialized the way the chain stores it
+        void add_packed(const eosio::name& table_name, const eosio::name& scope, const std::vector<char>& packed) {
+            if (_segments.empty() ||
+                _segments.back().header.table_name != table_name ||
+                _segments.back().header.scope != scope) {
+                _segments.push_back(segment{hydra_segment_header{table_name, scope, 0}, {}});
+            }
+
+            auto& current = _segments.back();
+            auto size = eosio::pack(uint32_t(packed.size()));
+            current.rows.insert(current.rows.end(), size.begin(), size.end());
+            current.rows.insert(current.rows.end(), packed.begin(), packed.end());
+            current.header.row_count++;
+
+            if (++_rows == _rows_per_chunk) {
+                flush();
+            }
+        }
+
+        void flush() {
+            if (_segments.empty()) {
+                return;
+            }
+
+            std::vector<char> chunk = eosio::pack(hydra_chunk_header{
+                HYDRA_CHUNK_MAGIC, _sequence++, uint32_t(_segments.size())
+            });
+            for (const auto& s : _segments) {
+                auto header = eosio::pack(s.header);
+                chunk.insert(chunk.end(), header.begin(), header.end());
+                chunk.insert(chunk.end(), s.rows.begin(), s.rows.end());
+            }
+
+            uint32_t size = chunk.size();
+            _out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            _out.write(chunk.data(), chunk.size());
+            _segments.clear();
+            _rows = 0;
+        }
+
+        uint64_t chunks_written() const { return _sequence; }
+
+    private:
+        struct segment {
+            hydra_segment_header header;
+            std::vector<char> rows;
+        };
+
+        std::ostream& _out;
+        uint32_t _rows_per_chunk;
+        uint32_t _rows = 0;
+        uint64_t _sequence = 0;
+        std::vector<segment> _segments;
+    };
+
+    struct synthetic_config {
+        uint32_t tenants            = 1;
+        uint32_t holders            = 1000;
+        uint32_t rows_per_chunk     = 500;
+        eosio::symbol symbol        = eosio::symbol("HVOICE", 2);
+        eosio::name issuer          = eosio::name("dao");
+        uint64_t now                = 1643242138;
+        uint64_t decay_period       = 60 * 60 * 24;
+        uint64_t decay_per_period_x10M = 200000;
+        uint64_t seed               = 1;
+    };
+
+    // Lowercase base 26 name with the given prefix, e.g. `h` -> haaaaaaab
+    inline eosio::name synthetic_name(char prefix, uint64_t index) {
+        std::string str(9, 'a');
+        str[0] = prefix;
+        for (std::size_t i = str.size() - 1; i > 0 && index > 0; --i, index /= 26) {
+            str[i] = char('a' + index % 26);
+        }
+        return eosio::name(str);
+    }
+
+    /**
+     * Writes a fixture where every one of `holders` members holds a balance
+     * of each of `tenants` tokens. Stats rows come first and their supply is
+     * the exact sum of the balances.
+     */
+    inline uint64_t write_synthetic(std::ostream& out, const synthetic_config& config) {
+        auto code = config.symbol.code();
+        uint64_t rng = config.seed;
+        auto next = [&rng] {
+            rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+            return rng >> 33;
+        };
+
+        std::vector<int64_t> balances(uint64_t(config.tenants) * config.holders);
+        std::vector<int64_t> supply(config.tenants, 0);
+        for (uint64_t i = 0; i < balances.size(); ++i) {
+            balances[i] = 1 + next() % 1000000;
+            supply[i % config.tenants] += balances[i];
+        }
+
+        chunk_writer writer(out, config.rows_per_chunk);
+        for (uint32_t t = 0; t < config.tenants; ++t) {
+            writer.add(eosio::name("stat.v2"), eosio::name(code.raw()), currency_statsv2{
+                .id                    = t,
+                .tenant                = synthetic_name('t', t),
+                .supply                = eosio::asset(supply[t], config.symbol),
+                .max_supply            = eosio::asset(-1, config.symbol),
+                .issuer                = config.issuer,
+                .decay_per_period_x10M = config.decay_per_period_x10M,
+                .decay_period          = config.decay_period
+            });
+        }
+
+        for (uint32_t h = 0; h < config.holders; ++h) {
+            auto holder = synthetic_name('h', h);
+            for (uint32_t t = 0; t < config.tenants; ++t) {
+                writer.add(eosio::name("accounts.v2"), holder, accountv2{
+                    .id                = t,
+                    .tenant            = synthetic_name('t', t),
+                    .balance           = eosio::asset(balances[uint64_t(h) * config.tenants + t], config.symbol),
+                    .last_decay_period = config.now - next() % (config.decay_period * 30 + 1)
+                });
+            }
+        }
+
+        writer.flush();
+        return writer.chunks_written();
+    }
+
+    struct table_rows_page {
+        std::vector<std::vector<char>> rows;
+        bool more = false;
+    };
+
+    /**
+     * Raw rows of a `get_table_rows` response requested with "json": false.
+     * Rows are hex strings, or {"data": "<hex>", "payer": ...} objects when
+     * "show_payer" is set. `more` is set when the response is not the last page.
+     */
+    inline table_rows_page parse_table_rows(const std::string& response) {
+        const char* malformed = "malformed get_table_rows response";
+        table_rows_page page;
+        std::size_t pos = 0;
+        auto skip_space = [&] {
+            while (pos < response.size() && std::isspace((unsigned char) response[pos])) {
+                pos++;
+            }
+        };
+        // Value of the string starting at `pos`, which is left past its closing quote
+        auto read_string = [&] {
+            eosio::check(pos < response.size() && response[pos] == '"', malformed);
+            auto end = response.find('"', pos + 1);
+            eosio::check(end != std::string::npos, malformed);
+            auto value = response.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+            return value;
+        };
+        auto from_hex = [&](const std::string& hex) {
+            auto digit = [&](char c) {
+                eosio::check(std::isxdigit((unsigned char) c), "row is not hex encoded, request it with \"json\": false");
+                return std::isdigit((unsigned char) c) ? c - '0' : std::tolower((unsigned char) c) - 'a' + 10;
+            };
+            eosio::check(hex.size() % 2 == 0, "row is not hex encoded, request it with \"json\": false");
+            std::vector<char> bytes(hex.size() / 2);
+            for (std::size_t i = 0; i < bytes.size(); ++i) {
+                bytes[i] = char(digit(hex[2 * i]) << 4 | digit(hex[2 * i + 1]));
+            }
+            return bytes;
+        };
+
+        pos = response.find("\"rows\"");
+        eosio::check(pos != std::string::npos, malformed);
+        pos = response.find('[', pos);
+        eosio::check(pos != std::string::npos, malformed);
+        pos++;
+        for (skip_space(); pos < response.size() && response[pos] != ']'; skip_space()) {
+            if (response[pos] == '{') {
+                auto end = response.find('}', pos);
+                pos = response.find("\"data\"", pos);
+                eosio::check(end != std::string::npos && pos < end, malformed);
+                pos = response.find(':', pos + 6);
+                eosio::check(pos < end, malformed);
+                pos++;
+                skip_space();
+                page.rows.push_back(from_hex(read_string()));
+                pos = end + 1;
+            } else {
+                page.rows.push_back(from_hex(read_string()));
+            }
+            skip_space();
+            if (pos < response.size() && response[pos] == ',') {
+                pos++;
+            }
+        }
+        eosio::check(pos < response.size(), malformed);
+
+        pos = response.find("\"more\"", pos);
+        if (pos != std::string::npos) {
+            pos = response.find(':', pos) + 1;
+            skip_space();
+            page.more = response.compare(pos, 4, "true") == 0;
+        }
+        return page;
+    }
+
+    // Inserts a segment of one of the voice.hypha tables
+    inline void insert_voice_segment(const eosio::name& self,
+                                     const hydra_segment_header& segment,
+                                     eosio::datastream<const char*>& ds) {
+        switch (segment.table_name.value) {
+            case eosio::name("accounts.v2").value:
+                hydra_insert_rows<accountv2, accounts>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("stat.v2").value:
+                hydra_insert_rows<currency_statsv2, stats>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("merkle.tree").value:
+                hydra_insert_rows<merkle_tree, merkle_trees>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("merkle.node").value:
+                hydra_insert_rows<merkle_node, merkle_nodes>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("merkle.leaf").value:
+                hydra_insert_rows<merkle_leaf, merkle_leaves>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("merkle.owner").value:
+                hydra_insert_rows<merkle_owner, merkle_owners>(self, segment.scope, ds, segment.row_count);
+                break;
+            case eosio::name("reconcile").value:
+                hydra_insert_rows<reconciliation, reconciliations>(self, segment.scope, ds, segment.row_count);
+                break;
+            default:
+                eosio::check(false, "Unknown table to load fixture");
+        }
+    }
+
+    // Writes every row `self` holds in the voice.hypha tables
+    inline void write_tables(chunk_writer& writer, const eosio::name& self) {
+        auto add = [&](const eosio::name& table_name) {
+            return [&, table_name](const eosio::name& code, uint64_t scope, const auto& row) {
+                if (code == self) {
+                    writer.add(table_name, eosio::name(scope), row);
+                }
+            };
+        };
+        stats::for_each_row(add(eosio::name("stat.v2")));
+        accounts::for_each_row(add(eosio::name("accounts.v2")));
+        merkle_trees::for_each_row(add(eosio::name("merkle.tree")));
+        merkle_nodes::for_each_row(add(eosio::name("merkle.node")));
+        merkle_leaves::for_each_row(add(eosio::name("merkle.leaf")));
+        merkle_owners::for_each_row(add(eosio::name("merkle.owner")));
+        reconciliations::for_each_row(add(eosio::name("reconcile")));
+        writer.flush();
+    }
+
+    /**
+     * Streams the chunks of a fixture file into the tables of `self`, one
+     * chunk buffer at a time. At most `max_chunks` chunks are applied, chunks
+     * loaded by a previous call are skipped.
+     *
+     * @return number of chunks applied by this call
+     */
+    inline uint64_t load_file(const eosio::name& self, const std::string& path,
+                              uint64_t max_chunks = UINT64_MAX) {
+        std::ifstream in(path, std::ios::binary);
+        eosio::check(in.good(), "unable to open fixture file " + path);
+
+        std::vector<char> buffer;
+        uint64_t applied = 0;
+        uint32_t size;
+        while (applied < max_chunks && in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+            buffer.resize(size);
+            eosio::check(bool(in.read(buffer.data(), size)), "truncated fixture file " + path);
+
+            auto insert = [&](const hydra_segment_header& segment, eosio::datastream<const char*>& ds) {
+                insert_voice_segment(self, segment, ds);
+            };
+            if (hydra_apply_chunk(self, buffer.data(), buffer.size(), insert)) {
+                applied++;
+            }
+        }
+        return applied;
+    }
+}
@@ -0,0 +1,41 @@
+#include <fixture.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+/**
+ * Writes a synthetic chunked fixture for load tests.
+ *
+ *   voice_fixture_gen <out> [--tenants N] [--holders N] [--rows-per-chunk N] [--seed N]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <out> [--tenants N] [--holders N] [--rows-per-chunk N] [--seed N]\n", argv[0]);
+        return 1;
+    }
+
+    hypha::fixture::synthetic_config config;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        auto value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--tenants") == 0) {
+            config.tenants = value;
+        } else if (std::strcmp(argv[i], "--holders") == 0) {
+            config.holders = value;
+        } else if (std::strcmp(argv[i], "--rows-per-chunk") == 0) {
+            config.rows_per_chunk = value;
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            config.seed = value;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+    auto chunks = hypha::fixture::write_synthetic(out, config);
+    std::printf("%s: %u tenants, %u holders, %llu chunks\n",
+                argv[1], config.tenants, config.holders, (unsigned long long)chunks);
+    return 0;
+}
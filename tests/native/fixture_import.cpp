@@ -0,0 +1,60 @@
+#include <fixture.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+/**
+ * Converts table rows fetched from a node into a chunked fixture.
+ *
+ *   voice_fixture_import <out> <table> <scope> <rows.json> [<table> <scope> <rows.json>]...
+ *
+ * Each rows.json is the response of get_table_rows for one table and scope,
+ * requested with "json": false so rows keep the bytes the contract stores,
+ * e.g. `cleos get table --binary <contract> <scope> <table> -l 1000`. The
+ * scopes of a table are listed by get_table_by_scope. A scope in uppercase
+ * is a symbol code, like the scope of stat.v2 and the merkle tables.
+ */
+int main(int argc, char** argv) {
+    if (argc < 5 || (argc - 2) % 3 != 0) {
+        std::fprintf(stderr, "usage: %s <out> <table> <scope> <rows.json> [<table> <scope> <rows.json>]...\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+        hypha::fixture::chunk_writer writer(out, hypha::fixture::synthetic_config{}.rows_per_chunk);
+        uint64_t rows = 0;
+        for (int i = 2; i < argc; i += 3) {
+            const eosio::name table_name(argv[i]);
+            const std::string scope_arg(argv[i + 1]);
+            const bool symbol_scope = std::any_of(scope_arg.begin(), scope_arg.end(),
+                                                  [](char c) { return std::isupper((unsigned char) c); });
+            const eosio::name scope = symbol_scope ? eosio::name(eosio::symbol_code(scope_arg).raw()) : eosio::name(scope_arg);
+
+            std::ifstream in(argv[i + 2]);
+            eosio::check(in.good(), std::string("unable to open ") + argv[i + 2]);
+            std::stringstream response;
+            response << in.rdbuf();
+
+            auto page = hypha::fixture::parse_table_rows(response.str());
+            if (page.more) {
+                std::fprintf(stderr, "warning: %s holds only the first page of %s/%s, raise the limit\n",
+                             argv[i + 2], argv[i], argv[i + 1]);
+            }
+            for (const auto& row : page.rows) {
+                writer.add_packed(table_name, scope, row);
+            }
+            rows += page.rows.size();
+        }
+
+        writer.flush();
+        std::printf("%s: %llu rows, %llu chunks\n", argv[1], (unsigned long long)rows, (unsigned long long)writer.chunks_written());
+        return 0;
+    } catch (const eosio::check_failure& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
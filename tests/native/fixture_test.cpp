@@ -0,0 +1,155 @@
+#include <cassert>
+#include <cstring>
+#include <fixture.hpp>
+#include <voice.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+using eosio::name;
+
+const name VOICE = "voice"_n;
+const eosio::symbol HVOICE = eosio::symbol("HVOICE", 2);
+
+std::string write_fixture(const hypha::fixture::synthetic_config& config) {
+    std::string path = "fixture_test.bin";
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    hypha::fixture::write_synthetic(out, config);
+    return path;
+}
+
+void test_roundtrip_rows() {
+    eosio::mock::reset();
+    hypha::fixture::synthetic_config config;
+    config.tenants = 3;
+    config.holders = 200;
+    config.rows_per_chunk = 64;
+    auto path = write_fixture(config);
+
+    assert(hypha::fixture::load_file(VOICE, path) == 10);
+
+    for (uint32_t t = 0; t < config.tenants; ++t) {
+        auto tenant = hypha::fixture::synthetic_name('t', t);
+        int64_t total = 0;
+        for (uint32_t h = 0; h < config.holders; ++h) {
+            auto holder = hypha::fixture::synthetic_name('h', h);
+            total += hypha::voice::get_balance(tenant, VOICE, holder, HVOICE.code()).amount;
+        }
+        assert(hypha::voice::get_supply(tenant, VOICE, HVOICE.code()).amount == total);
+    }
+
+    std::remove(path.c_str());
+}
+
+void test_resume_skips_loaded_chunks() {
+    eosio::mock::reset();
+    hypha::fixture::synthetic_config config;
+    config.holders = 1000;
+    config.rows_per_chunk = 100;
+    auto path = write_fixture(config);
+
+    // Interrupted after 4 of the 11 chunks, the second run applies the rest
+    assert(hypha::fixture::load_file(VOICE, path, 4) == 4);
+    assert(hypha::fixture::load_file(VOICE, path) == 7);
+    assert(hypha::fixture::load_file(VOICE, path) == 0);
+
+    assert(hydra_chunk_progress_table(VOICE, VOICE.value).get().next_sequence == 11);
+
+    auto last = hypha::fixture::synthetic_name('h', config.holders - 1);
+    assert(hypha::voice::get_balance(hypha::fixture::synthetic_name('t', 0), VOICE, last, HVOICE.code()).amount > 0);
+
+    std::remove(path.c_str());
+}
+
+template<typename RowType>
+std::string hex_row(const RowType& row) {
+    static const char* digits = "0123456789abcdef";
+    std::string result;
+    for (auto b : eosio::pack(row)) {
+        result += digits[(unsigned char) b >> 4];
+        result += digits[(unsigned char) b & 0xf];
+    }
+    return result;
+}
+
+void test_import_table_rows() {
+    eosio::mock::reset();
+    auto tenant = hypha::fixture::synthetic_name('t', 0);
+    auto balance = [&](uint64_t id, int64_t amount) {
+        return hypha::accountv2{ .id = id, .tenant = tenant, .balance = eosio::asset(amount, HVOICE), .last_decay_period = 1643242138 };
+    };
+
+    // Both shapes of get_table_rows with "json": false, with and without "show_payer"
+    auto stats = hypha::fixture::parse_table_rows("{\"rows\":[\"" + hex_row(hypha::currency_statsv2{
+        .id = 0, .tenant = tenant, .supply = eosio::asset(50, HVOICE), .max_supply = eosio::asset(-1, HVOICE),
+        .issuer = "dao"_n, .decay_per_period_x10M = 0, .decay_period = 0
+    }) + "\"],\"more\":false,\"next_key\":\"\"}");
+    auto accounts = hypha::fixture::parse_table_rows("{\n  \"rows\": [{\n      \"data\": \"" + hex_row(balance(0, 20)) +
+        "\",\n      \"payer\": \"dao\"\n    },{\n      \"data\": \"" + hex_row(balance(1, 30)) +
+        "\",\n      \"payer\": \"dao\"\n    }\n  ],\n  \"more\": true,\n  \"next_key\": \"2\"\n}");
+    assert(stats.rows.size() == 1 && !stats.more);
+    assert(accounts.rows.size() == 2 && accounts.more);
+
+    std::string path = "fixture_import.bin";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        hypha::fixture::chunk_writer writer(out, 2);
+        writer.add_packed("stat.v2"_n, name(HVOICE.code().raw()), stats.rows[0]);
+        for (const auto& row : accounts.rows) {
+            writer.add_packed("accounts.v2"_n, "member"_n, row);
+        }
+    }
+    assert(hypha::fixture::load_file(VOICE, path) == 2);
+    assert(hypha::voice::get_supply(tenant, VOICE, HVOICE.code()).amount == 50);
+    hypha::accounts acnts(VOICE, "member"_n.value);
+    assert(acnts.get(1).balance.amount == 30);
+
+    std::remove(path.c_str());
+}
+
+void test_reconcile_corrects_only_committed_fixtures() {
+    eosio::mock::reset();
+    hypha::voice c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+    hypha::fixture::synthetic_config config;
+    config.holders = 20;
+    auto path = write_fixture(config);
+    hypha::fixture::load_file(VOICE, path);
+    std::remove(path.c_str());
+
+    // The fixture rows predate the commitment, none of them is committed
+    auto tenant = hypha::fixture::synthetic_name('t', 0);
+    const auto supply = hypha::voice::get_supply(tenant, VOICE, HVOICE.code());
+    eosio::mock::set_time(config.now);
+    eosio::mock::set_auth({VOICE});
+    c.setcommit(tenant, HVOICE, true);
+    try {
+        c.reconcile(tenant, HVOICE, 100, true);
+        assert(false);
+    } catch (const eosio::check_failure& e) {
+        assert(std::strcmp(e.what(), "balances written before the commitment may be uncommitted, backfill them first") == 0);
+    }
+    auto status = c.reconcile(tenant, HVOICE, 100, false);
+    assert(status.done && status.holders == 0 && status.total.amount == 0);
+    assert(hypha::voice::get_supply(tenant, VOICE, HVOICE.code()) == supply);
+
+    std::vector<name> holders;
+    for (uint32_t h = 0; h < config.holders; ++h) {
+        holders.push_back(hypha::fixture::synthetic_name('h', h));
+    }
+    c.backfill(tenant, HVOICE, {holders.begin(), holders.begin() + 10}, false);
+    c.backfill(tenant, HVOICE, {holders.begin() + 10, holders.end()}, true);
+
+    status = c.reconcile(tenant, HVOICE, 100, true);
+    assert(status.done && status.holders == config.holders);
+    // Settling the decay of every holder keeps the supply equal to the sum
+    assert(status.total.amount > 0 && status.supply == status.total);
+    assert(hypha::voice::get_supply(tenant, VOICE, HVOICE.code()) == status.total);
+}
+
+int main(int argc, char** argv) {
+    test_roundtrip_rows();
+    test_resume_skips_loaded_chunks();
+    test_import_table_rows();
+    test_reconcile_corrects_only_committed_fixtures();
+    return 0;
+}
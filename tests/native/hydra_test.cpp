@@ -0,0 +1,115 @@
+#include <boost/preprocessor/seq/elem.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <fixture.hpp>
+#include <sstream>
+#include <voice.hpp>
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+
+const name VOICE = "voice"_n;
+const name TENANT = "foo"_n;
+const symbol HVOICE = symbol("HVOICE", 2);
+
+namespace hypha {
+
+    // Test contract with the fixture actions of tests/hydra.hpp over two of the voice tables
+    class hydra_fixture : public eosio::contract {
+    public:
+        using eosio::contract::contract;
+
+        HYDRA_FIXTURE_ACTION(((accounts.v2)(accountv2)(accounts))((stat.v2)(currency_statsv2)(stats)))
+        HYDRA_CHUNKED_FIXTURE_ACTION(((accounts.v2)(accountv2)(accounts))((stat.v2)(currency_statsv2)(stats)))
+    };
+}
+
+template<typename Action>
+bool fails_with(Action&& action, const char* message) {
+    try {
+        action();
+    } catch (const eosio::check_failure& e) {
+        return std::strcmp(e.what(), message) == 0;
+    }
+    return false;
+}
+
+hypha::accountv2 balance(uint64_t id, int64_t amount) {
+    return hypha::accountv2{ .id = id, .tenant = TENANT, .balance = asset(amount, HVOICE), .last_decay_period = 1643242138 };
+}
+
+// Chunks of the file written by a chunk_writer, without their size prefix
+std::vector<std::vector<char>> read_chunks(const std::string& file) {
+    std::vector<std::vector<char>> chunks;
+    for (std::size_t pos = 0; pos < file.size();) {
+        uint32_t size;
+        std::memcpy(&size, file.data() + pos, sizeof(size));
+        pos += sizeof(size);
+        chunks.emplace_back(file.data() + pos, file.data() + pos + size);
+        pos += size;
+    }
+    return chunks;
+}
+
+void test_chunked_action_applies_chunks_in_sequence() {
+    eosio::mock::reset();
+    hypha::hydra_fixture c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+
+    std::ostringstream out;
+    {
+        hypha::fixture::chunk_writer writer(out, 2);
+        writer.add(name("stat.v2"), name(HVOICE.code().raw()), hypha::currency_statsv2{
+            .id = 0, .tenant = TENANT, .supply = asset(30, HVOICE), .max_supply = asset(-1, HVOICE),
+            .issuer = "dao"_n, .decay_per_period_x10M = 0, .decay_period = 0
+        });
+        writer.add(name("accounts.v2"), "user1"_n, balance(0, 10));
+        writer.add(name("accounts.v2"), "user2"_n, balance(0, 20));
+    }
+    auto chunks = read_chunks(out.str());
+    assert(chunks.size() == 2);
+
+    eosio::mock::set_auth({VOICE});
+    assert(fails_with([&] { c.hydrachunk(chunks[0]); }, "missing authority of eosio"));
+
+    eosio::mock::set_auth({"eosio"_n});
+    assert(fails_with([&] { c.hydrachunk(chunks[1]); }, "Fixture chunk out of order"));
+    c.hydrachunk(chunks[0]);
+    c.hydrachunk(chunks[0]);
+    c.hydrachunk(chunks[1]);
+
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == asset(30, HVOICE));
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user2"_n, HVOICE.code()) == asset(20, HVOICE));
+    assert(hydra_chunk_progress_table(VOICE, VOICE.value).get().next_sequence == 2);
+
+    std::ostringstream unknown;
+    {
+        hypha::fixture::chunk_writer writer(unknown, 10);
+        writer.add(name("merkle.leaf"), "user1"_n, hypha::merkle_leaf{ .account_id = 0, .index = 0 });
+    }
+    auto rest = read_chunks(unknown.str());
+    // Sequence 0 again, skipped until the state is reset
+    c.hydrachunk(rest[0]);
+    eosio::mock::reset();
+    eosio::mock::set_auth({"eosio"_n});
+    assert(fails_with([&] { c.hydrachunk(rest[0]); }, "Unknown table to load fixture"));
+}
+
+void test_single_payload_action() {
+    eosio::mock::reset();
+    hypha::hydra_fixture c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+
+    eosio::mock::set_auth({"eosio"_n});
+    c.hydraload({ hydraload_payload{ name("accounts.v2"), "user1"_n, eosio::pack(balance(3, 7)) } });
+
+    hypha::accounts acnts(VOICE, "user1"_n.value);
+    assert(acnts.get(3).balance == asset(7, HVOICE));
+}
+
+int main(int argc, char** argv) {
+    test_chunked_action_applies_chunks_in_sequence();
+    test_single_payload_action();
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <fixture.hpp>
+#include <merkle.hpp>
+
+#include <cstdio>
+
+std::string hex(const eosio::checksum256& hash) {
+    static const char* digits = "0123456789abcdef";
+    std::string result;
+    for (auto b : hash.extract_as_byte_array()) {
+        result += digits[b >> 4];
+        result += digits[b & 0xf];
+    }
+    return result;
+}
+
+/**
+ * Prints the inclusion proof of a balance out of a table snapshot.
+ *
+ *   voice_merkle_proof <snapshot> <contract> <tenant> <symbol code> <owner>
+ *
+ * The snapshot is a fixture file (see tests/hydra.hpp) holding the rows of
+ * accounts.v2 and the merkle.* tables. voice_fixture_import writes one out
+ * of get_table_rows responses requested with "json": false.
+ */
+int main(int argc, char** argv) {
+    if (argc != 6) {
+        std::fprintf(stderr, "usage: %s <snapshot> <contract> <tenant> <symbol code> <owner>\n", argv[0]);
+        return 1;
+    }
+
+    const eosio::name contract(argv[2]);
+    const eosio::name tenant(argv[3]);
+    const eosio::symbol_code code(argv[4]);
+    const eosio::name owner(argv[5]);
+
+    try {
+        hypha::fixture::load_file(contract, argv[1]);
+        auto proof = hypha::merkle::get_proof(contract, tenant, owner, code);
+
+        std::printf("{\n  \"owner\": \"%s\",\n  \"balance\": \"%s\",\n  \"last_decay_period\": %llu,\n  \"index\": %llu,\n",
+                    owner.to_string().c_str(), proof.account.balance.to_string().c_str(),
+                    (unsigned long long)proof.account.last_decay_period, (unsigned long long)proof.index);
+        std::printf("  \"root\": \"%s\",\n  \"siblings\": [", hex(proof.root).c_str());
+        for (std::size_t i = 0; i < proof.siblings.size(); ++i) {
+            std::printf("%s\n    \"%s\"", i == 0 ? "" : ",", hex(proof.siblings[i]).c_str());
+        }
+        std::printf("\n  ],\n  \"verified\": %s\n}\n", hypha::merkle::verify(proof) ? "true" : "false");
+        return hypha::merkle::verify(proof) ? 0 : 2;
+    } catch (const eosio::check_failure& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
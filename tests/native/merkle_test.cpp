@@ -0,0 +1,253 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fixture.hpp>
+#include <fstream>
+#include <merkle.hpp>
+#include <voice.hpp>
+
+using eosio::asset;
+using eosio::checksum256;
+using eosio::name;
+using eosio::symbol;
+
+constexpr uint64_t ONE_DAY_SECONDS = 60 * 60 * 24;
+
+const name VOICE = "voice"_n;
+const name ISSUER = "dao"_n;
+const name TENANT = "foo"_n;
+const symbol HVOICE = symbol("HVOICE", 2);
+
+std::vector<name> members(uint64_t count) {
+    std::vector<name> result;
+    for (uint64_t i = 0; i < count; ++i) {
+        result.push_back(name("member" + std::string(1, char('a' + i / 26)) + char('a' + i % 26)));
+    }
+    return result;
+}
+
+hypha::voice setup(const std::vector<name>& holders) {
+    hypha::voice c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+    eosio::mock::reset();
+    eosio::mock::set_time(1643242138);
+    eosio::mock::create_accounts({VOICE, ISSUER});
+    eosio::mock::create_accounts(holders);
+
+    eosio::mock::set_auth({VOICE});
+    c.create(TENANT, ISSUER, asset(-1, HVOICE), ONE_DAY_SECONDS, hypha::BuildDecayPolicy::decays ? 5000000 : 0);
+    c.setcommit(TENANT, HVOICE, true);
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, asset(1000000, HVOICE), "memo");
+    return c;
+}
+
+hypha::merkle_tree tree() {
+    hypha::merkle_trees trees(VOICE, HVOICE.code().raw());
+    return trees.get_index<name("bykey")>().get(hypha::merkle_tree::build_key(TENANT, HVOICE.code()));
+}
+
+// Root recomputed from scratch out of every committed balance
+checksum256 rebuild_root(const std::vector<name>& holders) {
+    std::vector<checksum256> level(1ull << tree().depth);
+    for (auto owner : holders) {
+        hypha::accounts acnts(VOICE, owner.value);
+        auto index = acnts.get_index<name("bykey")>();
+        auto account = index.find(hypha::accountv2::build_key(TENANT, HVOICE.code()));
+        hypha::merkle_leaves leaves(VOICE, owner.value);
+        if (account != index.end() && leaves.find(account->id) != leaves.end()) {
+            level[leaves.get(account->id).index] = hypha::merkle::leaf_hash(owner, *account);
+        }
+    }
+
+    while (level.size() > 1) {
+        std::vector<checksum256> parent(level.size() / 2);
+        for (std::size_t i = 0; i < parent.size(); ++i) {
+            parent[i] = hypha::merkle::node_hash(level[2 * i], level[2 * i + 1]);
+        }
+        level = parent;
+    }
+    return level[0];
+}
+
+template<typename Action>
+bool fails_with(Action&& action, const char* message) {
+    try {
+        action();
+    } catch (const eosio::check_failure& e) {
+        return std::strcmp(e.what(), message) == 0;
+    }
+    return false;
+}
+
+void test_every_balance_has_a_valid_proof() {
+    auto holders = members(37);
+    auto c = setup(holders);
+
+    for (std::size_t i = 0; i < holders.size(); ++i) {
+        c.transfer(TENANT, ISSUER, holders[i], asset(100 + i, HVOICE), "memo");
+    }
+
+    holders.push_back(ISSUER);
+    assert(tree().leaf_count == holders.size());
+    assert(tree().depth == 6);
+    assert(tree().root == rebuild_root(holders));
+
+    for (auto owner : holders) {
+        auto proof = hypha::merkle::get_proof(VOICE, TENANT, owner, HVOICE.code());
+        assert(proof.siblings.size() == tree().depth);
+        assert(hypha::merkle::verify(proof));
+    }
+}
+
+void test_updates_move_the_root() {
+    auto holders = members(10);
+    auto c = setup(holders);
+    for (auto owner : holders) {
+        c.transfer(TENANT, ISSUER, owner, asset(500, HVOICE), "memo");
+    }
+
+    auto before = hypha::merkle::get_proof(VOICE, TENANT, holders[3], HVOICE.code());
+    c.transfer(TENANT, ISSUER, holders[7], asset(1, HVOICE), "memo");
+    auto after = hypha::merkle::get_proof(VOICE, TENANT, holders[3], HVOICE.code());
+
+    assert(before.root != after.root);
+    assert(hypha::merkle::verify(after));
+
+    // A stale proof doesn't verify against the new root
+    before.root = after.root;
+    assert(!hypha::merkle::verify(before));
+
+    // Neither does a forged balance
+    after.account.balance.amount += 1;
+    assert(!hypha::merkle::verify(after));
+
+    holders.push_back(ISSUER);
+    assert(tree().root == rebuild_root(holders));
+}
+
+void test_decay_and_removal_are_committed() {
+    auto holders = members(5);
+    auto c = setup(holders);
+    for (auto owner : holders) {
+        c.transfer(TENANT, ISSUER, owner, asset(800, HVOICE), "memo");
+    }
+
+    eosio::mock::advance_time(ONE_DAY_SECONDS);
+    c.decay(TENANT, holders[0], HVOICE);
+    auto proof = hypha::merkle::get_proof(VOICE, TENANT, holders[0], HVOICE.code());
+    assert(proof.account.balance.amount == int64_t(hypha::BuildDecayPolicy::apply(800, 1, 0.5)));
+    assert(hypha::merkle::verify(proof));
+
+    eosio::mock::set_auth({VOICE});
+    c.delbal(TENANT, holders[1], HVOICE);
+    assert(fails_with([&] { hypha::merkle::get_proof(VOICE, TENANT, holders[1], HVOICE.code()); }, "no balance object found"));
+    assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, holders[2], HVOICE.code())));
+
+    holders.push_back(ISSUER);
+    assert(tree().root == rebuild_root(holders));
+}
+
+void test_backfill_commits_untracked_balances() {
+    auto holders = members(3);
+    auto c = setup(holders);
+    c.transfer(TENANT, ISSUER, holders[0], asset(800, HVOICE), "memo");
+
+    // Simulates a balance written before the commitment existed
+    hypha::accounts acnts(VOICE, holders[1].value);
+    acnts.emplace(VOICE, [&](auto& a) {
+        a.id = acnts.available_primary_key();
+        a.tenant = TENANT;
+        a.balance = asset(300, HVOICE);
+        a.last_decay_period = 1643242138;
+    });
+    const auto billed = eosio::mock::rows_billed_to(VOICE);
+
+    // Anyone can decay, that doesn't commit the balance at the expense of the contract
+    eosio::mock::advance_time(ONE_DAY_SECONDS);
+    eosio::mock::set_auth({holders[2]});
+    c.decay(TENANT, holders[1], HVOICE);
+    assert(eosio::mock::rows_billed_to(VOICE) == billed);
+    assert(fails_with([&] { hypha::merkle::get_proof(VOICE, TENANT, holders[1], HVOICE.code()); }, "balance is not committed yet"));
+
+    assert(fails_with([&] { c.backfill(TENANT, HVOICE, {holders[1]}, false); }, "missing authority of voice"));
+    eosio::mock::set_auth({VOICE});
+    c.backfill(TENANT, HVOICE, {holders[0], holders[1], holders[2]}, false);
+    assert(eosio::mock::rows_billed_to(VOICE) > billed);
+    assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, holders[1], HVOICE.code())));
+    assert(tree().leaf_count == 3);
+    holders.push_back(ISSUER);
+    assert(tree().root == rebuild_root(holders));
+}
+
+void test_commitment_is_billed_to_the_balance_payer() {
+    auto holders = members(7);
+    auto c = setup(holders);
+    const auto billed = eosio::mock::rows_billed_to(VOICE);
+
+    c.openmany(TENANT, HVOICE, {holders.begin(), holders.begin() + 4}, ISSUER, true);
+    c.open(TENANT, holders[4], HVOICE, ISSUER);
+    c.transfer(TENANT, ISSUER, holders[5], asset(10, HVOICE), "memo");
+    eosio::mock::set_auth({ISSUER, holders[6]});
+    c.transfer(TENANT, ISSUER, holders[6], asset(10, HVOICE), "memo");
+    assert(eosio::mock::rows_billed_to(VOICE) == billed);
+    // balance, leaf and owner of every holder, plus the nodes
+    assert(eosio::mock::rows_billed_to(holders[6]) >= 3);
+    assert(eosio::mock::rows_billed_to(ISSUER) >= 6 * 3);
+}
+
+void test_openmany_matches_single_opens() {
+    auto holders = members(21);
+    auto c = setup(holders);
+    c.transfer(TENANT, ISSUER, holders[4], asset(7, HVOICE), "memo");
+    for (auto owner : holders) {
+        c.open(TENANT, owner, HVOICE, ISSUER);
+    }
+    auto expected = tree();
+
+    c = setup(holders);
+    c.transfer(TENANT, ISSUER, holders[4], asset(7, HVOICE), "memo");
+    c.openmany(TENANT, HVOICE, holders, ISSUER, true);
+    assert(tree().leaf_count == expected.leaf_count);
+    assert(tree().depth == expected.depth);
+    assert(tree().root == expected.root);
+
+    for (auto owner : holders) {
+        assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, owner, HVOICE.code())));
+    }
+    holders.push_back(ISSUER);
+    assert(tree().root == rebuild_root(holders));
+}
+
+void test_proof_from_snapshot() {
+    auto holders = members(20);
+    auto c = setup(holders);
+    for (auto owner : holders) {
+        c.transfer(TENANT, ISSUER, owner, asset(42, HVOICE), "memo");
+    }
+    auto root = tree().root;
+
+    {
+        std::ofstream out("merkle_snapshot.bin", std::ios::binary | std::ios::trunc);
+        hypha::fixture::chunk_writer writer(out, 16);
+        hypha::fixture::write_tables(writer, VOICE);
+    }
+
+    eosio::mock::reset();
+    hypha::fixture::load_file(VOICE, "merkle_snapshot.bin");
+    auto proof = hypha::merkle::get_proof(VOICE, TENANT, holders[11], HVOICE.code());
+    assert(proof.root == root);
+    assert(hypha::merkle::verify(proof));
+
+    std::remove("merkle_snapshot.bin");
+}
+
+int main(int argc, char** argv) {
+    test_every_balance_has_a_valid_proof();
+    test_updates_move_the_root();
+    test_decay_and_removal_are_committed();
+    test_backfill_commits_untracked_balances();
+    test_commitment_is_billed_to_the_balance_payer();
+    test_openmany_matches_single_opens();
+    test_proof_from_snapshot();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <fixture.hpp>
+#include <voice.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+/**
+ * Offline counterpart of the reconcile action, out of a table snapshot.
+ *
+ *   voice_reconcile <snapshot> <contract> <tenant> <symbol code> [timestamp]
+ *
+ * The snapshot is a fixture file (see tests/hydra.hpp), voice_fixture_import
+ * writes one out of get_table_rows responses. Every accounts.v2 row of the
+ * token is summed, committed or not, and the sum is compared to the supply in
+ * stat.v2. `decayed` is the same sum with every balance decayed to `timestamp`
+ * (default now), the supply once all of them are settled. `uncommitted` counts
+ * the rows without a merkle.leaf, which need a `backfill` before the reconcile
+ * action may correct the supply. Exits with 2 when the supply drifted.
+ */
+int main(int argc, char** argv) {
+    if (argc != 5 && argc != 6) {
+        std::fprintf(stderr, "usage: %s <snapshot> <contract> <tenant> <symbol code> [timestamp]\n", argv[0]);
+        return 1;
+    }
+
+    const eosio::name contract(argv[2]);
+    const eosio::name tenant(argv[3]);
+    const eosio::symbol_code code(argv[4]);
+    const uint64_t timestamp = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : (uint64_t) std::time(nullptr);
+
+    try {
+        hypha::fixture::load_file(contract, argv[1]);
+
+        hypha::stats statstable(contract, code.raw());
+        auto index = statstable.get_index<eosio::name("bykey")>();
+        const auto& st = index.get(hypha::currency_statsv2::build_key(tenant, code), "symbol does not exist");
+
+        const hypha::DecayConfig config = hypha::voice::get_decay_config(st, timestamp);
+
+        uint64_t holders = 0;
+        uint64_t uncommitted = 0;
+        int64_t balances = 0;
+        int64_t decayed = 0;
+        hypha::voice::with_decay_policy(st, [&](auto policy) {
+            hypha::DecayFactors<decltype(policy)> factors(config);
+            hypha::accounts::for_each_row([&](const eosio::name& owner_code, uint64_t owner, const hypha::accountv2& account) {
+                if (owner_code != contract || account.tenant != tenant || account.balance.symbol != st.supply.symbol) {
+                    return;
+                }
+                holders++;
+                hypha::merkle_leaves leaves(contract, owner);
+                if (leaves.find(account.id) == leaves.end()) {
+                    uncommitted++;
+                }
+                balances += account.balance.amount;
+                decayed += factors.decay(account.balance.amount, account.last_decay_period, account.decay_anchor(st.current_decay_revision())).newBalance;
+            });
+        });
+
+        const auto as_asset = [&](int64_t amount) { return eosio::asset(amount, st.supply.symbol).to_string(); };
+        std::printf("{\n  \"holders\": %llu,\n  \"uncommitted\": %llu,\n  \"supply\": \"%s\",\n  \"balances\": \"%s\",\n  \"drift\": \"%s\",\n"
+                    "  \"timestamp\": %llu,\n  \"decayed\": \"%s\"\n}\n",
+                    (unsigned long long) holders, (unsigned long long) uncommitted, st.supply.to_string().c_str(), as_asset(balances).c_str(),
+                    as_asset(st.supply.amount - balances).c_str(), (unsigned long long) timestamp,
+                    as_asset(decayed).c_str());
+        return st.supply.amount == balances ? 0 : 2;
+    } catch (const eosio::check_failure& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,109 @@
+#include <fixture.hpp>
+#include <voice.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+
+constexpr uint64_t ONE_DAY_SECONDS = 60 * 60 * 24;
+
+const name VOICE = "voice"_n;
+const name ISSUER = "dao"_n;
+const name TENANT = "foo"_n;
+const name STATIC_TENANT = "bar"_n;
+const name COMMITTED_TENANT = "baz"_n;
+const symbol HVOICE = symbol("HVOICE", 2);
+
+template<typename Action>
+void bench(const char* label, uint64_t iterations, Action&& action) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        action(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-20s %10llu calls %8.3f s %12.0f calls/s\n",
+                label, (unsigned long long)iterations, elapsed.count(), iterations / elapsed.count());
+}
+
+/**
+ * Runs the contract actions as plain calls so they can be profiled with
+ * perf and friends, e.g. `perf record ./voice_native_bench 1000000`.
+ *
+ * An optional fixture written by voice_fixture_gen is loaded first, so the
+ * actions run against a large state.
+ */
+int main(int argc, char** argv) {
+    const uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const uint64_t holders = 1000;
+
+    hypha::voice c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+
+    eosio::mock::reset();
+    if (argc > 2) {
+        bench("load", 1, [&](uint64_t) {
+            hypha::fixture::load_file(VOICE, argv[2]);
+        });
+    }
+    eosio::mock::set_time(1643242138);
+    eosio::mock::create_accounts({VOICE, ISSUER});
+    std::vector<name> members;
+    for (uint64_t i = 0; i < holders; ++i) {
+        members.push_back(name(name("member").value + (i << 4)));
+    }
+    eosio::mock::create_accounts(members);
+
+    eosio::mock::set_auth({VOICE});
+    c.create(TENANT, ISSUER, asset(-1, HVOICE), ONE_DAY_SECONDS, hypha::BuildDecayPolicy::decays ? 200000 : 0);
+    c.create(STATIC_TENANT, ISSUER, asset(-1, HVOICE), 0, 0);
+    c.create(COMMITTED_TENANT, ISSUER, asset(-1, HVOICE), ONE_DAY_SECONDS, hypha::BuildDecayPolicy::decays ? 200000 : 0);
+    c.setcommit(COMMITTED_TENANT, HVOICE, true);
+
+    eosio::mock::set_auth({ISSUER});
+    bench("issue", iterations, [&](uint64_t) {
+        c.issue(TENANT, ISSUER, asset(100, HVOICE), "memo");
+    });
+
+    // Same path for a decaying token, one that never decays and a decaying
+    // one whose balances are committed, which rehashes both paths to the root
+    for (auto tenant : {TENANT, STATIC_TENANT, COMMITTED_TENANT}) {
+        if (tenant != TENANT) {
+            c.issue(tenant, ISSUER, asset(iterations, HVOICE), "memo");
+        }
+        const char* label = tenant == TENANT ? "transfer/decaying" : tenant == STATIC_TENANT ? "transfer/static" : "transfer/committed";
+        bench(label, iterations, [&](uint64_t i) {
+            c.transfer(tenant, ISSUER, members[i % holders], asset(1, HVOICE), "memo");
+            if (i % holders == 0) {
+                eosio::mock::chain().recipients.clear();
+            }
+        });
+    }
+
+    eosio::mock::advance_time(ONE_DAY_SECONDS * 3);
+    bench("decay/decaying", iterations, [&](uint64_t i) {
+        c.decay(TENANT, members[i % holders], HVOICE);
+    });
+    bench("decay/static", iterations, [&](uint64_t i) {
+        c.decay(STATIC_TENANT, members[i % holders], HVOICE);
+    });
+
+    // The decay math alone, per policy
+    volatile uint64_t sink = 0;
+    auto policy_bench = [&](const char* label, auto policy) {
+        bench(label, iterations, [&](uint64_t i) {
+            sink = sink + hypha::decay<decltype(policy)>(1000000 + i, 0, hypha::DecayConfig{
+                .decayPeriod    = ONE_DAY_SECONDS,
+                .evaluationTime = ONE_DAY_SECONDS * (1 + i % 64),
+                .decayPerPeriod = 0.02
+            }).newBalance;
+        });
+    };
+    policy_bench("policy/exponential", hypha::ExponentialDecay{});
+    policy_bench("policy/linear", hypha::LinearDecay{});
+    policy_bench("policy/none", hypha::NoDecay{});
+
+    return 0;
+}
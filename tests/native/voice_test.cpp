@@ -0,0 +1,548 @@
+#include <cassert>
+#include <cstring>
+#include <merkle.hpp>
+#include <tables/old_voice.hpp>
+#include <voice.hpp>
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+
+constexpr uint64_t ONE_DAY_SECONDS = 60 * 60 * 24;
+constexpr uint64_t START_TIME = 1643242138;
+
+const name VOICE = "voice"_n;
+const name ISSUER = "dao"_n;
+const name TENANT = "foo"_n;
+const symbol HVOICE = symbol("HVOICE", 2);
+
+hypha::voice make_contract() {
+    return hypha::voice(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+}
+
+template<typename Action>
+bool fails_with(Action&& action, const char* message) {
+    try {
+        action();
+    } catch (const eosio::check_failure& e) {
+        return std::strcmp(e.what(), message) == 0;
+    }
+    return false;
+}
+
+asset hvoice(int64_t amount) {
+    return asset(amount, HVOICE);
+}
+
+// 50% per day, builds without decay only have tokens that don't decay
+constexpr uint64_t DECAY_X10M = hypha::BuildDecayPolicy::decays ? 5000000 : 0;
+
+// `amount` after `periods` days of the decay policy of the build
+asset decayed(int64_t amount, uint64_t periods) {
+    return hvoice(hypha::BuildDecayPolicy::apply(amount, periods, DECAY_X10M / (double) hypha::DECAY_PER_PERIOD_X10M));
+}
+
+// Token `foo` HVOICE decaying DECAY_X10M per day, issued by `dao`
+void setup_token(hypha::voice& c) {
+    eosio::mock::reset();
+    eosio::mock::set_time(START_TIME);
+    eosio::mock::create_accounts({VOICE, ISSUER, "user1"_n, "user2"_n});
+
+    eosio::mock::set_auth({VOICE});
+    c.create(TENANT, ISSUER, hvoice(-100), ONE_DAY_SECONDS, DECAY_X10M);
+}
+
+void test_create_requires_contract_auth() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    assert(fails_with([&] { c.create("bar"_n, ISSUER, hvoice(-100), 0, 0); }, "missing authority of voice"));
+
+    eosio::mock::set_auth({VOICE});
+    assert(fails_with([&] { c.create(TENANT, ISSUER, hvoice(-100), 0, 0); }, "token with symbol and tenant already exists"));
+}
+
+void test_issue_and_transfer() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(10000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(6000), "memo");
+
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == hvoice(10000));
+    assert(hypha::voice::get_balance(TENANT, VOICE, ISSUER, HVOICE.code()) == hvoice(4000));
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == hvoice(6000));
+    assert(eosio::mock::chain().recipients.size() == 2);
+
+    assert(fails_with([&] { c.transfer(TENANT, ISSUER, "user2"_n, hvoice(5000), "memo"); }, "overdrawn balance"));
+
+    eosio::mock::set_auth({"user1"_n});
+    assert(fails_with([&] { c.transfer(TENANT, "user1"_n, "user2"_n, hvoice(1), "memo"); },
+                      "tokens can only be transferred by issuer account"));
+}
+
+void test_tenants_are_isolated() {
+    auto c = make_contract();
+    setup_token(c);
+    c.create("bar"_n, ISSUER, hvoice(-100), ONE_DAY_SECONDS, DECAY_X10M);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(100), "memo");
+    c.issue("bar"_n, ISSUER, hvoice(120), "memo");
+
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == hvoice(100));
+    assert(hypha::voice::get_supply("bar"_n, VOICE, HVOICE.code()) == hvoice(120));
+    assert(hypha::voice::get_balance("bar"_n, VOICE, ISSUER, HVOICE.code()) == hvoice(120));
+}
+
+void test_decay_updates_balance_and_supply() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(25000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(25000), "memo");
+
+    eosio::mock::advance_time(ONE_DAY_SECONDS + 1);
+    c.decay(TENANT, "user1"_n, HVOICE);
+
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == decayed(25000, 1));
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == decayed(25000, 1));
+}
+
+// Settling a balance every period ends where settling it once does
+void test_settlements_compose() {
+    auto c = make_contract();
+    setup_token(c);
+    const uint64_t rate_x10M = hypha::BuildDecayPolicy::decays ? 1000000 : 0;
+    c.create("bar"_n, ISSUER, hvoice(-100), ONE_DAY_SECONDS, rate_x10M);
+    const auto after = [&](int64_t amount, uint64_t periods) {
+        return hvoice(hypha::BuildDecayPolicy::apply(amount, periods, rate_x10M / (double) hypha::DECAY_PER_PERIOD_X10M));
+    };
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue("bar"_n, ISSUER, hvoice(3000), "memo");
+    c.transfer("bar"_n, ISSUER, "user1"_n, hvoice(1000), "memo");
+    c.transfer("bar"_n, ISSUER, "user2"_n, hvoice(1000), "memo");
+
+    for (int day = 1; day <= 5; ++day) {
+        eosio::mock::advance_time(ONE_DAY_SECONDS);
+        c.decay("bar"_n, "user1"_n, HVOICE);
+        // A transfer restarts the decay from the new balance
+        if (day == 2) {
+            c.transfer("bar"_n, ISSUER, "user1"_n, hvoice(100), "memo");
+        }
+    }
+    c.decay("bar"_n, "user2"_n, HVOICE);
+
+    assert(hypha::voice::get_balance("bar"_n, VOICE, "user2"_n, HVOICE.code()) == after(1000, 5));
+    assert(hypha::voice::get_balance("bar"_n, VOICE, "user1"_n, HVOICE.code()) ==
+           after((after(1000, 2) + hvoice(100)).amount, 3));
+}
+
+// A rate changed after some decay was settled only applies to the following periods
+void test_moddecay_after_settled_decay() {
+    if constexpr (!hypha::BuildDecayPolicy::decays) {
+        return;
+    }
+    auto c = make_contract();
+    setup_token(c);
+    c.create("bar"_n, ISSUER, hvoice(-100), ONE_DAY_SECONDS, 1000000);
+    const auto at = [](int64_t amount, uint64_t periods, uint64_t rate_x10M) {
+        return hypha::BuildDecayPolicy::apply(amount, periods, rate_x10M / (double) hypha::DECAY_PER_PERIOD_X10M);
+    };
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue("bar"_n, ISSUER, hvoice(1000), "memo");
+    c.transfer("bar"_n, ISSUER, "user1"_n, hvoice(1000), "memo");
+
+    eosio::mock::advance_time(5 * ONE_DAY_SECONDS);
+    c.decay("bar"_n, "user1"_n, HVOICE);
+    const int64_t settled = at(1000, 5, 1000000);
+    assert(hypha::voice::get_balance("bar"_n, VOICE, "user1"_n, HVOICE.code()) == hvoice(settled));
+
+    eosio::mock::set_auth({VOICE});
+    c.moddecay("bar"_n, HVOICE, ONE_DAY_SECONDS, 500000);
+    eosio::mock::set_auth({});
+    int64_t expected = settled;
+    for (uint64_t day = 1; day <= 2; ++day) {
+        eosio::mock::advance_time(ONE_DAY_SECONDS);
+        c.decay("bar"_n, "user1"_n, HVOICE);
+        // Anchored policies decay from the balance settled before the change
+        expected = hypha::BuildDecayPolicy::anchored ? at(settled, day, 500000) : at(expected, 1, 500000);
+        assert(hypha::voice::get_balance("bar"_n, VOICE, "user1"_n, HVOICE.code()) == hvoice(expected));
+        assert(hypha::voice::get_supply("bar"_n, VOICE, HVOICE.code()) == hvoice(expected));
+    }
+
+    // Aligning the periods restarts the decay the same way, it never raises a balance
+    eosio::mock::set_auth({VOICE});
+    c.aligndecay("bar"_n, HVOICE, true);
+    const asset before = hypha::voice::get_balance("bar"_n, VOICE, "user1"_n, HVOICE.code());
+    eosio::mock::advance_time(ONE_DAY_SECONDS);
+    c.decay("bar"_n, "user1"_n, HVOICE);
+    assert(hypha::voice::get_balance("bar"_n, VOICE, "user1"_n, HVOICE.code()) == hvoice(at(before.amount, 1, 500000)));
+}
+
+void test_open_close_and_delbal() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    c.open(TENANT, "user2"_n, HVOICE, ISSUER);
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user2"_n, HVOICE.code()) == hvoice(0));
+    assert(fails_with([&] { c.open(TENANT, "nobody"_n, HVOICE, ISSUER); }, "owner account does not exist"));
+
+    eosio::mock::set_auth({"user2"_n});
+    c.close(TENANT, "user2"_n, HVOICE);
+    assert(fails_with([&] { c.close(TENANT, "user2"_n, HVOICE); },
+                      "Balance row already deleted or never existed. Action won't have any effect."));
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(300), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(100), "memo");
+
+    eosio::mock::set_auth({VOICE});
+    c.delbal(TENANT, "user1"_n, HVOICE);
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == hvoice(200));
+}
+
+void test_openmany_skips_existing_balances() {
+    auto c = make_contract();
+    setup_token(c);
+    c.setcommit(TENANT, HVOICE, true);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(300), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(100), "memo");
+
+    c.openmany(TENANT, HVOICE, {"user1"_n, "user2"_n, "user2"_n}, ISSUER, false);
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == hvoice(100));
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user2"_n, HVOICE.code()) == hvoice(0));
+
+    // Uncommitted balances join the commitment on their first update
+    hypha::accounts acnts(VOICE, "user2"_n.value);
+    hypha::merkle_leaves leaves(VOICE, "user2"_n.value);
+    assert(leaves.find(acnts.begin()->id) == leaves.end());
+    c.transfer(TENANT, ISSUER, "user2"_n, hvoice(5), "memo");
+    assert(leaves.find(acnts.begin()->id) != leaves.end());
+
+    assert(fails_with([&] { c.openmany(TENANT, HVOICE, {"user2"_n, "nobody"_n}, ISSUER, true); },
+                      "owner account does not exist"));
+    assert(fails_with([&] { c.openmany(TENANT, symbol("HVOICE", 3), {"user2"_n}, ISSUER, true); },
+                      "symbol precision mismatch"));
+    assert(fails_with([&] { c.openmany(TENANT, HVOICE, {"user2"_n}, "user1"_n, true); },
+                      "missing authority of user1"));
+}
+
+void test_setcommit_is_opt_in() {
+    auto c = make_contract();
+    setup_token(c);
+
+    // Without a commitment balance writes leave no merkle rows
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(300), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(100), "memo");
+    hypha::merkle_nodes nodes(VOICE, HVOICE.code().raw());
+    assert(nodes.begin() == nodes.end());
+    assert(fails_with([&] { c.backfill(TENANT, HVOICE, {"user1"_n}, true); }, "missing authority of voice"));
+    eosio::mock::set_auth({VOICE});
+    assert(fails_with([&] { c.backfill(TENANT, HVOICE, {"user1"_n}, true); },
+                      "token has no commitment, enable it with setcommit"));
+    assert(fails_with([&] { c.setcommit(TENANT, HVOICE, false); }, "token has no commitment"));
+
+    // Existing balances are committed by backfill
+    c.setcommit(TENANT, HVOICE, true);
+    assert(fails_with([&] { c.setcommit(TENANT, HVOICE, true); }, "token is already committed"));
+    c.backfill(TENANT, HVOICE, {ISSUER, "user1"_n}, true);
+    assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, "user1"_n, HVOICE.code())));
+    assert(fails_with([&] { c.setcommit(TENANT, HVOICE, false); },
+                      "the commitment still has leaves, close or delete their balances first"));
+
+    c.delbal(TENANT, "user1"_n, HVOICE);
+    c.delbal(TENANT, ISSUER, HVOICE);
+    c.setcommit(TENANT, HVOICE, false);
+    hypha::merkle_trees trees(VOICE, HVOICE.code().raw());
+    assert(trees.begin() == trees.end());
+}
+
+void test_del_drops_empty_commitment() {
+    auto c = make_contract();
+    setup_token(c);
+    c.setcommit(TENANT, HVOICE, true);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(300), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(100), "memo");
+    eosio::mock::set_auth({VOICE});
+    c.reconcile(TENANT, HVOICE, 1, false);
+    assert(fails_with([&] { c.del(TENANT, hvoice(0)); },
+                      "the commitment still has leaves, close or delete their balances first"));
+
+    // Recreated, the token starts without a commitment or a reconcile run
+    c.delbal(TENANT, "user1"_n, HVOICE);
+    c.delbal(TENANT, ISSUER, HVOICE);
+    c.del(TENANT, hvoice(0));
+    hypha::merkle_trees trees(VOICE, HVOICE.code().raw());
+    hypha::reconciliations progress(VOICE, HVOICE.code().raw());
+    assert(trees.begin() == trees.end() && progress.begin() == progress.end());
+    c.create(TENANT, ISSUER, hvoice(-100), ONE_DAY_SECONDS, DECAY_X10M);
+    c.setcommit(TENANT, HVOICE, true);
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(50), "memo");
+    assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, ISSUER, HVOICE.code())));
+}
+
+void test_reconcile_follows_changes_and_corrects() {
+    auto c = make_contract();
+    setup_token(c);
+    c.setcommit(TENANT, HVOICE, true);
+
+    eosio::mock::set_auth({VOICE, ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(1000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(100), "memo");
+    c.transfer(TENANT, ISSUER, "user2"_n, hvoice(200), "memo");
+
+    // Pages of one holder, leaves are dao, user1, user2
+    auto status = c.reconcile(TENANT, HVOICE, 1, false);
+    assert(!status.done && status.cursor == 1 && status.total == hvoice(700));
+
+    // dao was counted already, user2 is counted with the transfer
+    c.transfer(TENANT, ISSUER, "user2"_n, hvoice(50), "memo");
+    eosio::mock::advance_time(ONE_DAY_SECONDS);
+    const int64_t billed = eosio::mock::rows_billed_to(ISSUER);
+    c.reconcile(TENANT, HVOICE, 1, false);
+    status = c.reconcile(TENANT, HVOICE, 1, false);
+    assert(status.done && status.holders == 3);
+    assert(status.total == hvoice(650) + decayed(100, 1) + decayed(250, 1));
+    assert(status.supply == status.total);
+
+    // Without correcting nothing is settled, the rows keep their payer
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == hvoice(100));
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == hvoice(1000));
+    assert(eosio::mock::rows_billed_to(ISSUER) == billed);
+
+    hypha::stats statstable(VOICE, HVOICE.code().raw());
+    statstable.modify(statstable.begin(), VOICE, [](auto& s) { s.supply.amount += 3; });
+    const asset total = decayed(650, 1) + decayed(100, 1) + decayed(250, 1);
+    status = c.reconcile(TENANT, HVOICE, 10, false);
+    assert(status.done && status.supply == total + hvoice(3) && status.total == total);
+
+    // A correcting run settles every balance on the way, the first page was only read
+    status = c.reconcile(TENANT, HVOICE, 1, false);
+    status = c.reconcile(TENANT, HVOICE, 10, true);
+    assert(status.supply == total + hvoice(3));
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == total + (hvoice(650) - decayed(650, 1)));
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == decayed(100, 1));
+    eosio::mock::set_auth({ISSUER});
+    c.decay(TENANT, ISSUER, HVOICE);
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == total);
+    eosio::mock::set_auth({VOICE, ISSUER});
+
+    eosio::mock::set_auth({ISSUER});
+    assert(fails_with([&] { c.reconcile(TENANT, HVOICE, 10, true); }, "missing authority of voice"));
+}
+
+void test_migrate_resumes_and_skips_migrated() {
+    auto c = make_contract();
+    setup_token(c);
+    c.setcommit(TENANT, HVOICE, true);
+
+    const std::vector<name> holders = {"user1"_n, "user2"_n, "nobody"_n, ISSUER};
+    for (auto owner : {"user1"_n, "user2"_n, ISSUER}) {
+        old_voice::accounts old_accounts(VOICE, owner.value);
+        old_accounts.emplace(VOICE, [&](auto& a) {
+            a.balance = hvoice(owner.value % 1000);
+            a.last_decay_period = START_TIME - 10;
+        });
+    }
+
+    // dao holds a balance already, it must be left as is
+    eosio::mock::set_auth({VOICE, ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(77), "memo");
+    c.migqueue(TENANT, holders);
+
+    auto progress = c.migrate(TENANT, 3);
+    assert(progress.queued == 4 && progress.migrated == 2 && progress.missing == 1 && progress.skipped == 0);
+    progress = c.migrate(TENANT, 3);
+    assert(progress.migrated == 2 && progress.missing == 1 && progress.skipped == 0 && progress.conflicts == 1);
+
+    // Queued again, user1 is already migrated
+    c.migqueue(TENANT, {"user1"_n});
+    progress = c.migrate(TENANT, 3);
+    assert(progress.skipped == 1);
+    assert(progress.migrated + progress.missing + progress.skipped + progress.conflicts == progress.queued);
+
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user2"_n, HVOICE.code()) == hvoice("user2"_n.value % 1000));
+    assert(hypha::voice::get_balance(TENANT, VOICE, ISSUER, HVOICE.code()) == hvoice(77));
+    hypha::migration_conflicts conflicts(VOICE, TENANT.value);
+    assert(conflicts.get(ISSUER.value).legacy == hvoice(ISSUER.value % 1000));
+    assert(conflicts.get(ISSUER.value).balance == hvoice(77));
+    assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, "user1"_n, HVOICE.code())));
+
+    eosio::mock::set_auth({ISSUER});
+    assert(fails_with([&] { c.migrate(TENANT, 3); }, "missing authority of voice"));
+}
+
+void test_migrate_fills_opened_balances() {
+    auto c = make_contract();
+    setup_token(c);
+    c.setcommit(TENANT, HVOICE, true);
+
+    for (auto owner : {"user1"_n, "user2"_n}) {
+        old_voice::accounts old_accounts(VOICE, owner.value);
+        old_accounts.emplace(VOICE, [&](auto& a) {
+            a.balance = hvoice(400 + owner.value % 100);
+            a.last_decay_period = START_TIME - 10;
+        });
+    }
+
+    // Opened before the migration, committed or not
+    eosio::mock::set_auth({"user1"_n});
+    c.open(TENANT, "user1"_n, HVOICE, "user1"_n);
+    eosio::mock::set_auth({ISSUER});
+    c.openmany(TENANT, HVOICE, {"user2"_n}, ISSUER, false);
+
+    eosio::mock::set_auth({VOICE});
+    c.migqueue(TENANT, {"user1"_n, "user2"_n});
+    auto progress = c.migrate(TENANT, 10);
+    assert(progress.migrated == 2 && progress.skipped == 0 && progress.conflicts == 0);
+
+    for (auto owner : {"user1"_n, "user2"_n}) {
+        assert(hypha::voice::get_balance(TENANT, VOICE, owner, HVOICE.code()) == hvoice(400 + owner.value % 100));
+        assert(hypha::merkle::verify(hypha::merkle::get_proof(VOICE, TENANT, owner, HVOICE.code())));
+    }
+}
+
+void test_aligned_decay_shares_epoch_boundaries() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    assert(fails_with([&] { c.aligndecay(TENANT, HVOICE, true); }, "missing authority of voice"));
+    eosio::mock::set_auth({VOICE, ISSUER});
+    c.aligndecay(TENANT, HVOICE, true);
+
+    c.issue(TENANT, ISSUER, hvoice(1000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(400), "memo");
+    eosio::mock::advance_time(30000);
+    c.transfer(TENANT, ISSUER, "user2"_n, hvoice(400), "memo");
+
+    // Both balances decay on the same day boundary, user2 less than a day after its transfer
+    const uint64_t boundary = (START_TIME / ONE_DAY_SECONDS + 1) * ONE_DAY_SECONDS;
+    eosio::mock::set_time(boundary);
+    auto tally = c.tally(TENANT, HVOICE, {"user1"_n, "user2"_n}, 0);
+    assert(tally.weights[0] == decayed(400, 1) && tally.weights[1] == decayed(400, 1));
+
+    c.decay(TENANT, "user2"_n, HVOICE);
+    hypha::accounts acnts(VOICE, "user2"_n.value);
+    assert(acnts.begin()->balance == decayed(400, 1));
+    if constexpr (hypha::BuildDecayPolicy::decays) {
+        assert(acnts.begin()->last_decay_period == boundary);
+    }
+
+    c.aligndecay(TENANT, HVOICE, false);
+    eosio::mock::advance_time(ONE_DAY_SECONDS - 1);
+    c.decay(TENANT, "user2"_n, HVOICE);
+    assert(acnts.begin()->balance == decayed(400, 1));
+}
+
+void test_tally_projects_decay_without_writes() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(30000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(20000), "memo");
+    c.transfer(TENANT, ISSUER, "user2"_n, hvoice(4000), "memo");
+
+    eosio::mock::set_auth({});
+    auto now = hypha::voice::get_vote_weights(TENANT, VOICE, HVOICE, {"user1"_n, "user2"_n, "nobody"_n}, START_TIME);
+    assert(now.weights.size() == 3);
+    assert(now.weights[0] == hvoice(20000));
+    assert(now.weights[2] == hvoice(0));
+    assert(now.total == hvoice(24000));
+
+    // Two periods later both balances are halved twice, stored rows are untouched
+    auto later = c.tally(TENANT, HVOICE, {"user1"_n, "user2"_n, "nobody"_n}, START_TIME + 2 * ONE_DAY_SECONDS);
+    assert(later.weights[0] == decayed(20000, 2));
+    assert(later.weights[1] == decayed(4000, 2));
+    assert(later.total == decayed(20000, 2) + decayed(4000, 2));
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == hvoice(20000));
+    assert(hypha::voice::get_supply(TENANT, VOICE, HVOICE.code()) == hvoice(30000));
+
+    // Matches what decaying each voter settles
+    eosio::mock::advance_time(2 * ONE_DAY_SECONDS);
+    assert(c.tally(TENANT, HVOICE, {"user1"_n}, 0).total == decayed(20000, 2));
+    c.decay(TENANT, "user1"_n, HVOICE);
+    assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == decayed(20000, 2));
+
+    assert(fails_with([&] { c.tally(TENANT, symbol("HVOICE", 4), {"user1"_n}, 0); }, "symbol precision mismatch"));
+    assert(fails_with([&] { c.tally(TENANT, HVOICE, {"user1"_n, "user2"_n, "user1"_n}, 0); }, "duplicate voter"));
+}
+
+void test_decay_curve_matches_settled_balances() {
+    auto c = make_contract();
+    setup_token(c);
+
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, hvoice(1000), "memo");
+    c.transfer(TENANT, ISSUER, "user1"_n, hvoice(400), "memo");
+    eosio::mock::advance_time(1000);
+
+    auto curve = c.decaycurve(TENANT, "user1"_n, HVOICE, 3, 0);
+    assert(curve.size() == 3);
+    for (uint64_t i = 0; i < curve.size(); ++i) {
+        assert(curve[i].time == START_TIME + (i + 1) * ONE_DAY_SECONDS && curve[i].balance == decayed(400, i + 1));
+    }
+
+    auto crossing = c.decaybelow(TENANT, "user1"_n, hvoice(60), 0);
+    assert(!c.decaybelow(TENANT, "user1"_n, hvoice(0), 0).crosses);
+    if constexpr (!hypha::BuildDecayPolicy::decays) {
+        assert(!crossing.crosses);
+    } else {
+        // First point below the threshold, a balance of 400 is below it within 3 days
+        uint64_t below = 0;
+        while (curve[below].balance.amount >= 60) {
+            ++below;
+        }
+        assert(below > 0 && crossing.crosses && crossing.time == curve[below].time);
+
+        // Evaluated past the crossing, the time stays the boundary it settles below at
+        auto later = c.decaybelow(TENANT, "user1"_n, hvoice(60), crossing.time + ONE_DAY_SECONDS);
+        assert(later.crosses && later.time == crossing.time);
+
+        // Settling one second early keeps the balance above the threshold
+        eosio::mock::set_time(crossing.time - 1);
+        c.decay(TENANT, "user1"_n, HVOICE);
+        assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == curve[below - 1].balance);
+        eosio::mock::set_time(crossing.time);
+        c.decay(TENANT, "user1"_n, HVOICE);
+        assert(hypha::voice::get_balance(TENANT, VOICE, "user1"_n, HVOICE.code()) == curve[below].balance);
+    }
+
+    assert(fails_with([&] { c.decaycurve(TENANT, "user1"_n, HVOICE, hypha::MAX_DECAY_POINTS + 1, 0); }, "too many periods"));
+    assert(fails_with([&] { c.decaycurve(TENANT, "user2"_n, HVOICE, 3, 0); }, "no balance object found"));
+    assert(fails_with([&] { c.decaybelow(TENANT, "user1"_n, asset(60, symbol("HVOICE", 3)), 0); }, "symbol precision mismatch"));
+}
+
+int main(int argc, char** argv) {
+    test_create_requires_contract_auth();
+    test_issue_and_transfer();
+    test_tenants_are_isolated();
+    test_decay_updates_balance_and_supply();
+    test_settlements_compose();
+    test_moddecay_after_settled_decay();
+    test_open_close_and_delbal();
+    test_openmany_skips_existing_balances();
+    test_setcommit_is_opt_in();
+    test_del_drops_empty_commitment();
+    test_reconcile_follows_changes_and_corrects();
+    test_migrate_resumes_and_skips_migrated();
+    test_migrate_fills_opened_balances();
+    test_aligned_decay_shares_epoch_boundaries();
+    test_decay_curve_matches_settled_balances();
+    test_tally_projects_decay_without_writes();
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <fixture.hpp>
+#include <voice.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+using eosio::asset;
+using eosio::name;
+using eosio::symbol;
+
+constexpr uint64_t ONE_DAY_SECONDS = 60 * 60 * 24;
+
+const name VOICE = "voice"_n;
+const name ISSUER = "dao"_n;
+const name TENANT = "foo"_n;
+const symbol HVOICE = symbol("HVOICE", 2);
+
+/**
+ * Runs each action of the tracing build (VOICE_TRACE) once and prints its
+ * VOICE_PROFILE line, e.g. `./voice_native_trace 10000 fixture.bin`.
+ *
+ * The state is first filled with `holders` balances (and an optional fixture
+ * written by voice_fixture_gen) with the profiles of that setup discarded.
+ */
+int main(int argc, char** argv) {
+    const uint64_t holders = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+
+    hypha::voice c(VOICE, VOICE, eosio::datastream<const char*>(nullptr, 0));
+
+    eosio::mock::reset();
+    if (argc > 2) {
+        hypha::fixture::load_file(VOICE, argv[2]);
+    }
+    eosio::mock::set_time(1643242138);
+    eosio::mock::create_accounts({VOICE, ISSUER, "newholder"_n});
+    std::vector<name> members;
+    for (uint64_t i = 0; i < holders; ++i) {
+        members.push_back(name(name("member").value + (i << 4)));
+    }
+    eosio::mock::create_accounts(members);
+    std::vector<name> onboarded;
+    for (uint64_t i = 0; i < 100; ++i) {
+        onboarded.push_back(name(name("onboard").value + (i << 4)));
+    }
+    eosio::mock::create_accounts(onboarded);
+
+    std::cout.setstate(std::ios::failbit);
+    eosio::mock::set_auth({VOICE});
+    c.create(TENANT, ISSUER, asset(-1, HVOICE), ONE_DAY_SECONDS, hypha::BuildDecayPolicy::decays ? 200000 : 0);
+    c.setcommit(TENANT, HVOICE, true);
+    eosio::mock::set_auth({ISSUER});
+    c.issue(TENANT, ISSUER, asset(100 * (holders + 10), HVOICE), "memo");
+    for (const auto& member : members) {
+        c.transfer(TENANT, ISSUER, member, asset(100, HVOICE), "memo");
+    }
+    eosio::mock::chain().recipients.clear();
+    std::cout.clear();
+
+    c.issue(TENANT, ISSUER, asset(100, HVOICE), "memo");
+    c.transfer(TENANT, ISSUER, members[holders / 2], asset(1, HVOICE), "memo");
+
+    eosio::mock::set_auth({"newholder"_n});
+    c.open(TENANT, "newholder"_n, HVOICE, "newholder"_n);
+    c.close(TENANT, "newholder"_n, HVOICE);
+    eosio::mock::set_auth({ISSUER});
+    c.openmany(TENANT, HVOICE, onboarded, ISSUER, true);
+
+    eosio::mock::advance_time(ONE_DAY_SECONDS * 3);
+    c.transfer(TENANT, ISSUER, members[0], asset(1, HVOICE), "memo");
+    c.decay(TENANT, members[1], HVOICE);
+    c.burn(TENANT, ISSUER, asset(1, HVOICE), "memo");
+    c.tally(TENANT, HVOICE, std::vector<name>(members.begin(), members.begin() + std::min<uint64_t>(holders, 100)), 0);
+
+    return 0;
+}